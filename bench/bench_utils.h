@@ -0,0 +1,96 @@
+/*
+ * DSP Benchmark Helpers
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+#define BENCH_LEN 65536  // samples per timed run
+#define BENCH_BLOCK 64  // samples per block call
+#define BENCH_REPEATS 5  // the fastest of this many runs is reported
+
+// get the time in ns
+inline double bench_now(void) {
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// time a job that runs a number of samples
+// returns the fastest run in ns per sample
+template <typename Job>
+double bench_time(Job job, int len) {
+    double start, time, best = 0.0;
+    int i;
+    for(i = 0; i < BENCH_REPEATS; i ++) {
+        start = bench_now();
+        job();
+        time = bench_now() - start;
+        if(i == 0 || time < best) {
+            best = time;
+        }
+    }
+    return best / len;
+}
+
+// keep a result so the work that made it can't be optimized away
+inline void bench_keep(float in) {
+    __asm__ __volatile__("" : : "g"(in) : "memory");
+}
+
+// fill a buffer with white noise from a fixed seed
+// out - the buffer
+// len - the number of samples
+// seed - the noise seed
+inline void bench_noise(float *out, int len, uint32_t seed) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        seed = (seed * 1664525) + 1013904223;
+        out[i] = (int32_t)seed / 2147483648.0f;
+    }
+}
+
+// get the largest difference between two buffers
+inline float bench_max_diff(const float *a, const float *b, int len) {
+    float diff = 0.0f;
+    int i;
+    for(i = 0; i < len; i ++) {
+        diff = fmaxf(diff, fabsf(a[i] - b[i]));
+    }
+    return diff;
+}
+
+// print a check result
+// returns 1 if the check failed, 0 if it passed
+inline int bench_check(const char *name, float diff, float tolerance) {
+    if(diff > tolerance) {
+        printf("check %-32s FAIL - off by %g\n", name, diff);
+        return 1;
+    }
+    printf("check %-32s ok - off by %g\n", name, diff);
+    return 0;
+}
+
+#endif
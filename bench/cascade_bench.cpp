@@ -0,0 +1,146 @@
+/*
+ * Biquad Cascade Benchmark
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Times Filter2PoleCascade against a serial chain of Filter2Pole sections
+ * with the same design and checks that the cascade output matches the
+ * chain once its latency is taken out. Times are in ns per sample.
+ *
+ */
+#include "bench_utils.h"
+#include "utils/DspUtils2.h"
+#include <vector>
+
+using namespace dsp2;
+
+#define BENCH_FREQ 1000.0f
+#define BENCH_FS 48000.0f
+
+// serial chain of Filter2Pole sections
+struct SerialChain {
+    Filter2Pole sect[Filter2PoleCascade::SECTIONS];
+    int num;
+
+    // set the sections to the same design as Filter2PoleCascade
+    // order - the Butterworth order
+    // repeat - 1 = repeat the Butterworth sections for a Linkwitz-Riley filter
+    void setButterworth(int order, int repeat) {
+        int i, k;
+        num = 0;
+        for(k = 0; k <= repeat; k ++) {
+            for(i = 0; i < order / 2; i ++) {
+                sect[num].setCutoff(Filter2Pole::TYPE_LPF, BENCH_FREQ,
+                    0.5f / sinf((float)(2 * i + 1) * (float)M_PI / (float)(2 * order)),
+                    1.0f, BENCH_FS);
+                num ++;
+            }
+        }
+    }
+
+    float process(float in) {
+        int i;
+        for(i = 0; i < num; i ++) {
+            in = sect[i].process(in);
+        }
+        return in;
+    }
+
+    void processBlock(const float *in, float *out, int len) {
+        int i;
+        sect[0].processBlock(in, out, len);
+        for(i = 1; i < num; i ++) {
+            sect[i].processBlock(out, len);
+        }
+    }
+};
+
+// check a cascade design against the serial chain
+// returns 1 if the check failed, 0 if it passed
+static int bench_check_design(const char *name, Filter2PoleCascade casc, SerialChain chain,
+        const std::vector<float> &in) {
+    const int lat = Filter2PoleCascade::LATENCY;
+    std::vector<float> ref(BENCH_LEN), out(BENCH_LEN);
+    int i, fails;
+    for(i = 0; i < BENCH_LEN; i ++) {
+        ref[i] = chain.process(in[i]);
+        out[i] = casc.process(in[i]);
+    }
+    fails = bench_check(name, bench_max_diff(ref.data(), &out[lat], BENCH_LEN - lat), 0.0f);
+    casc.reset();
+    for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+        casc.processBlock(&in[i], &out[i], BENCH_BLOCK);
+    }
+    fails += bench_check("  block", bench_max_diff(ref.data(), &out[lat], BENCH_LEN - lat), 0.0f);
+    return fails;
+}
+
+int main(int argc, char **argv) {
+    std::vector<float> in(BENCH_LEN), out(BENCH_LEN);
+    Filter2PoleCascade casc;
+    SerialChain chain;
+    double ns_serial, ns_serial_block, ns_casc, ns_casc_block;
+    int i, fails = 0;
+    bench_noise(in.data(), BENCH_LEN, 1);
+
+    casc.setButterworth(Filter2Pole::TYPE_LPF, 8, BENCH_FREQ, BENCH_FS);
+    chain.setButterworth(8, 0);
+    fails += bench_check_design("Butterworth 8th order", casc, chain, in);
+    casc.setLinkwitzRiley(Filter2Pole::TYPE_LPF, 8, BENCH_FREQ, BENCH_FS);
+    chain.setButterworth(4, 1);
+    fails += bench_check_design("Linkwitz-Riley 8th order", casc, chain, in);
+
+    // 8th order Butterworth - all 4 sections in use
+    casc.setButterworth(Filter2Pole::TYPE_LPF, 8, BENCH_FREQ, BENCH_FS);
+    chain.setButterworth(8, 0);
+    ns_serial = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            out[i] = chain.process(in[i]);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_serial_block = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+            chain.processBlock(&in[i], &out[i], BENCH_BLOCK);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_casc = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            out[i] = casc.process(in[i]);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_casc_block = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+            casc.processBlock(&in[i], &out[i], BENCH_BLOCK);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    printf("bench 8th order    serial: %6.2f  serial block: %6.2f  cascade: %6.2f  cascade block: %6.2f\n",
+        ns_serial, ns_serial_block, ns_casc, ns_casc_block);
+    printf("bench cascade speedup: %.2fx per sample, %.2fx block\n",
+        ns_serial / ns_casc, ns_serial_block / ns_casc_block);
+
+    if(fails) {
+        printf("%d checks failed\n", fails);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Filter Block Processing Benchmark
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Times the per-sample and block calls of LevelSense, Filter1Pole and
+ * Filter2Pole and checks that both give the same output. Times are in ns
+ * per sample.
+ *
+ */
+#include "bench_utils.h"
+#include "utils/DspUtils2.h"
+#include <vector>
+
+using namespace dsp2;
+
+// time the per-sample and block calls of a filter and check them
+// name - the filter name
+// filt - the filter set up for the test
+// sample - runs one sample through a filter
+// block - runs a block through a filter
+// returns 1 if the check failed, 0 if it passed
+template <typename Filt, typename Sample, typename Block>
+int bench_filter(const char *name, const Filt &filt, Sample sample, Block block) {
+    std::vector<float> in(BENCH_LEN), ref(BENCH_LEN), out(BENCH_LEN);
+    Filt a = filt;
+    Filt b = filt;
+    double ns_sample, ns_block;
+    int i, fails;
+    bench_noise(in.data(), BENCH_LEN, 1);
+
+    // both calls must give the same output from the same state
+    for(i = 0; i < BENCH_LEN; i ++) {
+        ref[i] = sample(a, in[i]);
+    }
+    for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+        block(b, &in[i], &out[i], BENCH_BLOCK);
+    }
+    fails = bench_check(name, bench_max_diff(ref.data(), out.data(), BENCH_LEN), 0.0f);
+    // in place
+    out = in;
+    b = filt;
+    for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+        block(b, &out[i], &out[i], BENCH_BLOCK);
+    }
+    fails += bench_check("  in place", bench_max_diff(ref.data(), out.data(), BENCH_LEN), 0.0f);
+
+    ns_sample = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            out[i] = sample(a, in[i]);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_block = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+            block(b, &in[i], &out[i], BENCH_BLOCK);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    printf("bench %-20s per-sample: %6.2f  block: %6.2f  speedup: %.2fx\n",
+        name, ns_sample, ns_block, ns_sample / ns_block);
+    return fails;
+}
+
+int main(int argc, char **argv) {
+    LevelSense level;
+    Filter1Pole filt1;
+    Filter2Pole filt2;
+    int fails = 0;
+
+    level.setAttack(0.01f, 48000.0f);
+    level.setRelease(0.3f, 48000.0f);
+    fails += bench_filter("LevelSense", level,
+        [](LevelSense &f, float in) { return f.process(in); },
+        [](LevelSense &f, const float *in, float *out, int len) { f.processBlock(in, out, len); });
+
+    filt1.setCutoff(500.0f, 48000.0f);
+    fails += bench_filter("Filter1Pole lowpass", filt1,
+        [](Filter1Pole &f, float in) { return f.lowpass(in); },
+        [](Filter1Pole &f, const float *in, float *out, int len) { f.lowpassBlock(in, out, len); });
+    fails += bench_filter("Filter1Pole highpass", filt1,
+        [](Filter1Pole &f, float in) { return f.highpass(in); },
+        [](Filter1Pole &f, const float *in, float *out, int len) { f.highpassBlock(in, out, len); });
+
+    filt2.setCutoff(Filter2Pole::TYPE_PEAK, 1000.0f, 2.0f, 2.0f, 48000.0f);
+    fails += bench_filter("Filter2Pole", filt2,
+        [](Filter2Pole &f, float in) { return f.process(in); },
+        [](Filter2Pole &f, const float *in, float *out, int len) { f.processBlock(in, out, len); });
+
+    if(fails) {
+        printf("%d checks failed\n", fails);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * FIR Filter Benchmark
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Times FIRFilter from 16 to 1024 taps against a scalar kernel that
+ * splits the dot product around the history position, and checks the
+ * per-sample and block calls against a direct form reference worked out
+ * in double. Times are in ns per sample.
+ *
+ */
+#include "bench_utils.h"
+#include "utils/DspUtils2.h"
+#include <vector>
+
+using namespace dsp2;
+
+#define BENCH_TAP_SIZES 8
+#define BENCH_FIR_TOLERANCE 4e-6f  // allowed difference from the double reference - a few float ulps at full scale
+
+static const int bench_taps[BENCH_TAP_SIZES] = {16, 32, 33, 64, 128, 256, 512, 1024};
+
+// scalar FIR with a single length history - two loops around histpos
+struct ScalarFIR {
+    std::vector<float> hist;
+    std::vector<float> coeffs;
+    int histpos;
+    int numtaps;
+
+    ScalarFIR(int taps, const float *coeffs) : hist(taps, 0.0f), coeffs(coeffs, coeffs + taps) {
+        histpos = 0;
+        numtaps = taps;
+    }
+
+    float process(float in) {
+        float sum = 0.0f;
+        int i, n = 0;
+        hist[histpos] = in;
+        for(i = histpos; i >= 0; i --) {
+            sum += coeffs[n ++] * hist[i];
+        }
+        for(i = numtaps - 1; i > histpos; i --) {
+            sum += coeffs[n ++] * hist[i];
+        }
+        histpos ++;
+        if(histpos == numtaps) {
+            histpos = 0;
+        }
+        return sum;
+    }
+};
+
+// direct form reference in double
+// in - the input samples
+// out - the output samples
+// coeffs - the coeffs
+// taps - the number of taps
+static void bench_fir_ref(const std::vector<float> &in, std::vector<float> &out,
+        const std::vector<float> &coeffs, int taps) {
+    double sum;
+    int i, k;
+    for(i = 0; i < (int)in.size(); i ++) {
+        sum = 0.0;
+        for(k = 0; k < taps && k <= i; k ++) {
+            sum += (double)coeffs[k] * in[i - k];
+        }
+        out[i] = (float)sum;
+    }
+}
+
+// check and time one tap count
+// returns the number of failed checks
+static int bench_fir(int taps) {
+    std::vector<float> in(BENCH_LEN), ref(BENCH_LEN), out(BENCH_LEN), coeffs(taps);
+    double ns_scalar, ns_sample, ns_block;
+    char name[64];
+    int i, fails;
+    bench_noise(in.data(), BENCH_LEN, 1);
+    // a windowed sinc lowpass so the output stays in range
+    for(i = 0; i < taps; i ++) {
+        float x = (i - (taps - 1) * 0.5f) * 0.25f;
+        coeffs[i] = (x == 0.0f ? 1.0f : sinf(M_PI * x) / (M_PI * x)) *
+            (0.5f - 0.5f * cosf(2.0f * M_PI * (i + 0.5f) / taps)) * 0.25f;
+    }
+    bench_fir_ref(in, ref, coeffs, taps);
+
+    FIRFilter sample(taps, coeffs.data());
+    FIRFilter block(taps, coeffs.data());
+    ScalarFIR scalar(taps, coeffs.data());
+    for(i = 0; i < BENCH_LEN; i ++) {
+        out[i] = sample.process(in[i]);
+    }
+    snprintf(name, sizeof(name), "%d taps", taps);
+    fails = bench_check(name, bench_max_diff(ref.data(), out.data(), BENCH_LEN), BENCH_FIR_TOLERANCE);
+    for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+        block.process(&in[i], &out[i], BENCH_BLOCK);
+    }
+    fails += bench_check("  block", bench_max_diff(ref.data(), out.data(), BENCH_LEN), BENCH_FIR_TOLERANCE);
+    for(i = 0; i < BENCH_LEN; i ++) {
+        out[i] = scalar.process(in[i]);
+    }
+    fails += bench_check("  scalar", bench_max_diff(ref.data(), out.data(), BENCH_LEN), BENCH_FIR_TOLERANCE);
+
+    ns_scalar = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            out[i] = scalar.process(in[i]);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_sample = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            out[i] = sample.process(in[i]);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_block = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i += BENCH_BLOCK) {
+            block.process(&in[i], &out[i], BENCH_BLOCK);
+        }
+        bench_keep(out[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    printf("bench %4d taps  scalar: %8.2f  per-sample: %8.2f  block: %8.2f  speedup: %.2fx\n",
+        taps, ns_scalar, ns_sample, ns_block, ns_scalar / ns_block);
+    return fails;
+}
+
+int main(int argc, char **argv) {
+    int i, fails = 0;
+    for(i = 0; i < BENCH_TAP_SIZES; i ++) {
+        fails += bench_fir(bench_taps[i]);
+    }
+    if(fails) {
+        printf("%d checks failed\n", fails);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Allpass Phase Shifter Benchmark
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Times the vector allpass phase shifters against AllpassPhaseShifter and
+ * checks that AllpassPhaseShifterVec matches it exactly with no latency and
+ * that AllpassPhaseShifterPipelined matches it once its latency is taken out.
+ * Times are in ns per sample.
+ *
+ */
+#include "bench_utils.h"
+#include "utils/DspUtils2.h"
+#include <vector>
+
+using namespace dsp2;
+
+int main(int argc, char **argv) {
+    const int lat = AllpassPhaseShifterPipelined::LATENCY;
+    std::vector<float> in(BENCH_LEN);
+    std::vector<float> ref_del(BENCH_LEN), ref_shift(BENCH_LEN);
+    std::vector<float> del(BENCH_LEN), shift(BENCH_LEN);
+    double ns_scalar, ns_vec, ns_pipe;
+    int i, fails = 0;
+    bench_noise(in.data(), BENCH_LEN, 1);
+
+    // reference
+    AllpassPhaseShifter scalar;
+    for(i = 0; i < BENCH_LEN; i ++) {
+        scalar.process(in[i], &ref_del[i], &ref_shift[i]);
+    }
+
+    // zero latency vector
+    AllpassPhaseShifterVec vec;
+    for(i = 0; i < BENCH_LEN; i ++) {
+        vec.process(in[i], &del[i], &shift[i]);
+    }
+    fails += bench_check("vector del", bench_max_diff(ref_del.data(), del.data(), BENCH_LEN), 0.0f);
+    fails += bench_check("vector shift", bench_max_diff(ref_shift.data(), shift.data(), BENCH_LEN), 0.0f);
+
+    // pipelined vector
+    AllpassPhaseShifterPipelined pipe;
+    for(i = 0; i < BENCH_LEN; i ++) {
+        pipe.process(in[i], &del[i], &shift[i]);
+    }
+    fails += bench_check("pipelined del", bench_max_diff(ref_del.data(), &del[lat], BENCH_LEN - lat), 0.0f);
+    fails += bench_check("pipelined shift", bench_max_diff(ref_shift.data(), &shift[lat], BENCH_LEN - lat), 0.0f);
+
+    ns_scalar = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            scalar.process(in[i], &del[i], &shift[i]);
+        }
+        bench_keep(shift[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_vec = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            vec.process(in[i], &del[i], &shift[i]);
+        }
+        bench_keep(shift[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    ns_pipe = bench_time([&]() {
+        for(i = 0; i < BENCH_LEN; i ++) {
+            pipe.process(in[i], &del[i], &shift[i]);
+        }
+        bench_keep(shift[BENCH_LEN - 1]);
+    }, BENCH_LEN);
+    printf("bench phase shifter    scalar: %6.2f  vector: %6.2f  pipelined: %6.2f\n",
+        ns_scalar, ns_vec, ns_pipe);
+    printf("bench phase shifter speedup: %.2fx vector, %.2fx pipelined\n",
+        ns_scalar / ns_vec, ns_scalar / ns_pipe);
+
+    if(fails) {
+        printf("%d checks failed\n", fails);
+        return 1;
+    }
+    return 0;
+}
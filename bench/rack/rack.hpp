@@ -0,0 +1,205 @@
+/*
+ * Minimal Rack API Shim for the Headless Benchmarks
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Only the parts of the Rack 2 API used by the module DSP code are here
+ * so a module struct can be built and driven without Rack. The widget
+ * code is stripped from the module source by the bench Makefile.
+ *
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <pmmintrin.h>
+
+// JSON - state is never saved or loaded by the benchmarks
+struct json_t;
+inline json_t *json_object(void) { return NULL; }
+inline json_t *json_object_get(json_t *, const char *) { return NULL; }
+inline int json_object_set_new(json_t *, const char *, json_t *) { return 0; }
+inline json_t *json_integer(long long) { return NULL; }
+inline long long json_integer_value(json_t *) { return 0; }
+inline bool json_is_integer(json_t *) { return false; }
+inline json_t *json_array(void) { return NULL; }
+inline size_t json_array_size(json_t *) { return 0; }
+inline json_t *json_array_get(json_t *, size_t) { return NULL; }
+inline int json_array_append_new(json_t *, json_t *) { return 0; }
+
+namespace rack {
+
+namespace logger {
+enum Level {
+    DEBUG_LEVEL,
+    INFO_LEVEL,
+    WARN_LEVEL,
+    FATAL_LEVEL
+};
+
+inline void log(Level level, const char *file, int line, const char *func, const char *format, ...) { }
+}
+
+namespace random {
+inline void init(void) { }
+}
+
+namespace simd {
+// 4 lane float vector - same operators as the Rack SSE version
+struct float_4 {
+    __m128 v;
+
+    float_4() { }
+    float_4(__m128 v) : v(v) { }
+    float_4(float x) { v = _mm_set1_ps(x); }
+    float_4(float a, float b, float c, float d) { v = _mm_setr_ps(a, b, c, d); }
+    static float_4 zero(void) { return float_4(_mm_setzero_ps()); }
+    static float_4 load(const float *p) { return float_4(_mm_loadu_ps(p)); }
+    void store(float *p) { _mm_storeu_ps(p, v); }
+    float &operator[](int i) { return ((float *)&v)[i]; }
+    const float &operator[](int i) const { return ((const float *)&v)[i]; }
+    static constexpr int size = 4;
+};
+
+inline float_4 operator+(float_4 a, float_4 b) { return _mm_add_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a, float_4 b) { return _mm_sub_ps(a.v, b.v); }
+inline float_4 operator*(float_4 a, float_4 b) { return _mm_mul_ps(a.v, b.v); }
+inline float_4 operator/(float_4 a, float_4 b) { return _mm_div_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a) { return _mm_sub_ps(_mm_setzero_ps(), a.v); }
+inline float_4 &operator+=(float_4 &a, float_4 b) { return a = a + b; }
+inline float_4 &operator-=(float_4 &a, float_4 b) { return a = a - b; }
+inline float_4 &operator*=(float_4 &a, float_4 b) { return a = a * b; }
+inline float_4 &operator/=(float_4 &a, float_4 b) { return a = a / b; }
+inline float_4 fmax(float_4 a, float_4 b) { return _mm_max_ps(a.v, b.v); }
+inline float_4 fmin(float_4 a, float_4 b) { return _mm_min_ps(a.v, b.v); }
+inline float_4 abs(float_4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline float_4 trunc(float_4 a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)); }
+}
+
+namespace dsp {
+// returns true every division calls
+struct ClockDivider {
+    uint32_t clock = 0;
+    uint32_t division = 1;
+
+    void reset(void) { clock = 0; }
+    void setDivision(uint32_t division) { this->division = division; }
+    bool process(void) {
+        if(++ clock >= division) {
+            clock = 0;
+            return true;
+        }
+        return false;
+    }
+};
+}
+
+namespace engine {
+struct Param {
+    float value = 0.0f;
+
+    float getValue(void) { return value; }
+    void setValue(float value) { this->value = value; }
+};
+
+struct Port {
+    float voltages[16] = {};
+    int channels = 0;
+
+    float getVoltage(int c = 0) { return voltages[c]; }
+    void setVoltage(float voltage, int c = 0) { voltages[c] = voltage; }
+    int getChannels(void) { return channels; }
+    void setChannels(int channels) { this->channels = channels; }
+    bool isConnected(void) { return channels > 0; }
+    template <typename T> T getPolyVoltageSimd(int c) {
+        return channels == 1 ? T(voltages[0]) : T::load(&voltages[c]);
+    }
+    template <typename T> void setVoltageSimd(T voltage, int c) { voltage.store(&voltages[c]); }
+};
+
+struct Input : Port { };
+struct Output : Port { };
+
+struct Light {
+    float value = 0.0f;
+
+    void setBrightness(float brightness) { value = brightness; }
+};
+
+struct Engine {
+    float sampleRate = 48000.0f;
+
+    float getSampleRate(void) { return sampleRate; }
+};
+
+struct Module {
+    std::vector<Param> params;
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<Light> lights;
+
+    struct ProcessArgs {
+        float sampleRate;
+        float sampleTime;
+        int64_t frame;
+    };
+
+    virtual ~Module() { }
+    void config(int numParams, int numInputs, int numOutputs, int numLights) {
+        params.resize(numParams);
+        inputs.resize(numInputs);
+        outputs.resize(numOutputs);
+        lights.resize(numLights);
+    }
+    void configParam(int paramId, float minValue, float maxValue, float defaultValue,
+        std::string name = "", std::string unit = "") { }
+    void configInput(int portId, std::string name = "") { }
+    void configOutput(int portId, std::string name = "") { }
+    virtual void process(const ProcessArgs& args) { }
+    virtual void onReset(void) { }
+    virtual void onSampleRateChange(void) { }
+    virtual json_t *dataToJson(void) { return NULL; }
+    virtual void dataFromJson(json_t *root) { }
+};
+}
+
+// the one engine the benchmarks set the samplerate on
+struct Context {
+    engine::Engine *engine;
+};
+
+inline Context *contextGet(void) {
+    static engine::Engine engine;
+    static Context context = {&engine};
+    return &context;
+}
+
+struct Plugin;
+struct Model;
+
+using namespace engine;
+
+}  // namespace rack
+
+#define APP rack::contextGet()
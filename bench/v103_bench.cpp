@@ -0,0 +1,470 @@
+/*
+ * Dintree V103 Reverb Delay Benchmark
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Drives the V103 DSP headless at each samplerate and switch setting with
+ * an impulse, noise and silence. Reports the time per sample, the time the
+ * network takes to sleep after the noise, peak RSS and cache misses, and
+ * records the energy decay curve of each impulse response so it can be
+ * checked against a reference file.
+ *
+ * The silence is timed once the network is asleep so it measures the idle
+ * path. Each setting runs in its own process so the peak RSS is for that
+ * setting alone.
+ *
+ * The curves are compared within EDC_TOLERANCE and not bit for bit - the
+ * echo taps are worked out in double and interpolated as
+ * tap + (next - tap) * fract since the multi-tap echo went in, so the
+ * output is not bit-identical to the per-tap reads of the original code
+ * when a tap lands between samples.
+ *
+ * usage: v103_bench [-w edc_file] [-c edc_file]
+ *   -w - write the energy decay curves to edc_file
+ *   -c - compare the energy decay curves against edc_file
+ *
+ */
+#include "v103_module.hpp"
+#include <chrono>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define BENCH_RATES 4
+#define BENCH_TIME 2.0  // seconds of noise and silence to time
+#define SLEEP_STEP 0.1  // seconds of silence between sleep checks
+#define SLEEP_TIME_MAX 300.0  // longest to wait for the network to sleep
+#define BENCH_LEVEL 5.0  // impulse and noise level in volts
+#define EDC_TIME 6.0  // seconds of impulse response to record
+#define EDC_STEP 0.1  // seconds between curve points
+#define EDC_POINTS 50
+#define EDC_FLOOR -60.0  // curve points below this are not compared
+#define EDC_TOLERANCE 0.1  // allowed curve difference in dB
+
+static const int bench_rates[BENCH_RATES] = {44100, 48000, 96000, 192000};
+
+// cache miss counter - reads -1 if perf counters are not available
+struct BenchMissCounter {
+    int fd;
+
+    BenchMissCounter() {
+        fd = -1;
+#if defined(__linux__)
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~BenchMissCounter() {
+#if defined(__linux__)
+        if(fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    void start(void) {
+#if defined(__linux__)
+        if(fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    long long stop(void) {
+        long long count = -1;
+#if defined(__linux__)
+        if(fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(fd, &count, sizeof(count)) != sizeof(count)) {
+                count = -1;
+            }
+        }
+#endif
+        return count;
+    }
+};
+
+// results for one samplerate and switch setting
+struct BenchResult {
+    int fs;
+    int rev_sw;
+    int del_sw;
+    double ns_impulse;  // ns per sample with the impulse
+    double ns_noise;  // ns per sample with noise
+    double ns_silence;  // ns per sample with silence once the network sleeps
+    double sleep_time;  // seconds of silence before the network sleeps - -1 = never
+    double miss_noise;  // cache misses per sample with noise - -1 = not available
+    long rss_kb;  // peak RSS of the setting
+    float edc[EDC_POINTS];  // energy decay curve in dB
+};
+
+// get the peak RSS in KB
+static long bench_peak_rss(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// find out if the network is asleep
+// returns 1 if it is asleep, 0 if it is awake or -1 if the source has
+// no sleep - the reference curves can be built from older sources
+template <typename T>
+static auto bench_asleep(T *module, int) -> decltype(module->sleeping, int()) {
+    return module->sleeping ? 1 : 0;
+}
+
+template <typename T>
+static int bench_asleep(T *module, long) {
+    return -1;
+}
+
+// white noise from a fixed seed so every run sees the same input
+static float bench_noise(uint32_t *seed) {
+    *seed = (*seed * 1664525) + 1013904223;
+    return ((int32_t)*seed / 2147483648.0f) * BENCH_LEVEL;
+}
+
+// run the module for a number of samples
+// in - input level for each sample - NULL = use the noise or silence
+// noise - 1 = feed noise, 0 = feed silence
+// out - energy of each sample - NULL = don't keep it
+// returns the time taken in ns
+static double bench_run(V103_Reverb_Delay *module, int fs, int len, int noise,
+        const float *in, double *out) {
+    Module::ProcessArgs args;
+    uint32_t seed = 12345;
+    float l, r;
+    int i;
+    args.sampleRate = fs;
+    args.sampleTime = 1.0f / fs;
+    args.frame = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(i = 0; i < len; i ++) {
+        if(in != NULL) {
+            module->inputs[V103_Reverb_Delay::INL].setVoltage(in[i]);
+        }
+        else if(noise) {
+            module->inputs[V103_Reverb_Delay::INL].setVoltage(bench_noise(&seed));
+        }
+        else {
+            module->inputs[V103_Reverb_Delay::INL].setVoltage(0.0f);
+        }
+        module->process(args);
+        args.frame ++;
+        if(out != NULL) {
+            l = module->outputs[V103_Reverb_Delay::OUTL].getVoltage();
+            r = module->outputs[V103_Reverb_Delay::OUTR].getVoltage();
+            out[i] = ((double)l * l) + ((double)r * r);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// work out the energy decay curve of an impulse response
+// energy - the energy of each sample
+// len - the number of samples
+// fs - the samplerate
+// edc - the curve in dB relative to the total energy
+static void bench_edc(const double *energy, int len, int fs, float *edc) {
+    std::vector<double> tail(len + 1);
+    int i, pos;
+    tail[len] = 0.0;
+    for(i = len - 1; i >= 0; i --) {
+        tail[i] = tail[i + 1] + energy[i];
+    }
+    for(i = 0; i < EDC_POINTS; i ++) {
+        pos = (int)(i * EDC_STEP * fs);
+        if(pos >= len || tail[0] <= 0.0 || tail[pos] <= 0.0) {
+            edc[i] = -200.0f;
+            continue;
+        }
+        edc[i] = (float)(10.0 * log10(tail[pos] / tail[0]));
+    }
+}
+
+// run silence until the network sleeps
+// returns the seconds of silence it took or -1 if it did not sleep
+static double bench_sleep(V103_Reverb_Delay *module, int fs) {
+    int len, step;
+    if(bench_asleep(module, 0) < 0) {
+        return -1.0;
+    }
+    step = (int)(SLEEP_STEP * fs);
+    for(len = 0; len < (int)(SLEEP_TIME_MAX * fs); len += step) {
+        if(bench_asleep(module, 0)) {
+            return (double)len / fs;
+        }
+        bench_run(module, fs, step, 0, NULL, NULL);
+    }
+    return -1.0;
+}
+
+// benchmark one samplerate and switch setting
+static void bench_setting(int fs, int rev_sw, int del_sw, BenchResult *result) {
+    V103_Reverb_Delay *module;
+    BenchMissCounter misses;
+    std::vector<float> impulse;
+    std::vector<double> energy;
+    long long count;
+    int len;
+
+    // the constructor allocates the delay memory for this rate
+    APP->engine->sampleRate = fs;
+    module = new V103_Reverb_Delay();
+    module->inputs[V103_Reverb_Delay::INL].setChannels(1);
+    module->params[V103_Reverb_Delay::REV_SW].setValue(rev_sw);
+    module->params[V103_Reverb_Delay::DEL_SW].setValue(del_sw);
+    module->setParams();
+
+    result->fs = fs;
+    result->rev_sw = rev_sw;
+    result->del_sw = del_sw;
+
+    // impulse response
+    len = (int)(EDC_TIME * fs);
+    impulse.assign(len, 0.0f);
+    impulse[0] = BENCH_LEVEL;
+    energy.resize(len);
+    result->ns_impulse = bench_run(module, fs, len, 0, impulse.data(), energy.data()) / len;
+    bench_edc(energy.data(), len, fs, result->edc);
+
+    // noise and then silence once the tails have died away
+    len = (int)(BENCH_TIME * fs);
+    misses.start();
+    result->ns_noise = bench_run(module, fs, len, 1, NULL, NULL) / len;
+    count = misses.stop();
+    result->miss_noise = count < 0 ? -1.0 : (double)count / len;
+    result->sleep_time = bench_sleep(module, fs);
+    result->ns_silence = bench_run(module, fs, len, 0, NULL, NULL) / len;
+
+    delete module;
+    result->rss_kb = bench_peak_rss();
+}
+
+// benchmark one samplerate and switch setting in a child process
+// returns -1 on error
+static int bench_setting_child(int fs, int rev_sw, int del_sw, BenchResult *result) {
+    int fds[2], status;
+    ssize_t len;
+    pid_t pid;
+    if(pipe(fds)) {
+        return -1;
+    }
+    fflush(stdout);
+    pid = fork();
+    if(pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if(pid == 0) {
+        close(fds[0]);
+        bench_setting(fs, rev_sw, del_sw, result);
+        len = write(fds[1], result, sizeof(*result));
+        _exit(len == (ssize_t)sizeof(*result) ? 0 : 1);
+    }
+    close(fds[1]);
+    len = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+    if(waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        return -1;
+    }
+    return len == (ssize_t)sizeof(*result) ? 0 : -1;
+}
+
+// write the curves to a file
+// returns -1 on error
+static int bench_write_edc(const char *filename, const std::vector<BenchResult> &results) {
+    FILE *f;
+    int i, k;
+    f = fopen(filename, "w");
+    if(f == NULL) {
+        return -1;
+    }
+    fprintf(f, "# V103 energy decay curves - fs rev_sw del_sw then %d points in dB every %gs\n",
+        EDC_POINTS, EDC_STEP);
+    for(i = 0; i < (int)results.size(); i ++) {
+        fprintf(f, "%d %d %d", results[i].fs, results[i].rev_sw, results[i].del_sw);
+        for(k = 0; k < EDC_POINTS; k ++) {
+            fprintf(f, " %.3f", results[i].edc[k]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return 0;
+}
+
+// compare the curves against a file
+// returns the number of settings that are out of tolerance or -1 on error
+static int bench_compare_edc(const char *filename, const std::vector<BenchResult> &results) {
+    FILE *f;
+    char line[4096];
+    char *pos, *end;
+    int fs, rev_sw, del_sw, i, k, found, fails;
+    float ref, diff, worst;
+    f = fopen(filename, "r");
+    if(f == NULL) {
+        return -1;
+    }
+    fails = 0;
+    for(i = 0; i < (int)results.size(); i ++) {
+        found = 0;
+        worst = 0.0f;
+        rewind(f);
+        while(fgets(line, sizeof(line), f) != NULL) {
+            if(line[0] == '#' || sscanf(line, "%d %d %d", &fs, &rev_sw, &del_sw) != 3) {
+                continue;
+            }
+            if(fs != results[i].fs || rev_sw != results[i].rev_sw || del_sw != results[i].del_sw) {
+                continue;
+            }
+            // skip the three setting fields
+            pos = line;
+            for(k = 0; k < 3; k ++) {
+                strtol(pos, &end, 10);
+                pos = end;
+            }
+            for(k = 0; k < EDC_POINTS; k ++) {
+                ref = strtof(pos, &end);
+                if(end == pos) {
+                    break;
+                }
+                pos = end;
+                if(ref < EDC_FLOOR && results[i].edc[k] < EDC_FLOOR) {
+                    continue;
+                }
+                diff = fabsf(ref - results[i].edc[k]);
+                if(diff > worst) {
+                    worst = diff;
+                }
+            }
+            found = (k == EDC_POINTS);
+            break;
+        }
+        printf("edc fs: %6d  rev: %d  del: %d  ", results[i].fs, results[i].rev_sw, results[i].del_sw);
+        if(!found) {
+            printf("no reference\n");
+            fails ++;
+        }
+        else if(worst > EDC_TOLERANCE) {
+            printf("FAIL - %.3fdB off\n", worst);
+            fails ++;
+        }
+        else {
+            printf("ok - %.3fdB off\n", worst);
+        }
+    }
+    fclose(f);
+    return fails;
+}
+
+int main(int argc, char **argv) {
+    std::vector<BenchResult> results;
+    BenchResult result;
+    const char *write_file = NULL;
+    const char *compare_file = NULL;
+    int i, rev_sw, del_sw, fails;
+
+    for(i = 1; i < argc; i ++) {
+        if(strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            write_file = argv[++ i];
+        }
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            compare_file = argv[++ i];
+        }
+        else {
+            fprintf(stderr, "usage: %s [-w edc_file] [-c edc_file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // denormals flush to zero on the Rack engine thread
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+
+    printf("times are ns per sample, sleep is seconds of silence before the network\n");
+    printf("sleeps and misses are cache misses per sample\n");
+    printf("    fs  rev  del   impulse     noise   silence   sleep    misses  peak RSS\n");
+    for(i = 0; i < BENCH_RATES; i ++) {
+        for(rev_sw = 0; rev_sw < 2; rev_sw ++) {
+            for(del_sw = 0; del_sw < 3; del_sw ++) {
+                if(bench_setting_child(bench_rates[i], rev_sw, del_sw, &result)) {
+                    fprintf(stderr, "could not run: fs: %d rev: %d del: %d\n",
+                        bench_rates[i], rev_sw, del_sw);
+                    return 2;
+                }
+                results.push_back(result);
+                printf("%6d  %3d  %3d  %8.1f  %8.1f  %8.1f  ", result.fs, result.rev_sw,
+                    result.del_sw, result.ns_impulse, result.ns_noise, result.ns_silence);
+                if(result.sleep_time < 0.0) {
+                    printf("%6s  ", "n/a");
+                }
+                else {
+                    printf("%6.1f  ", result.sleep_time);
+                }
+                if(result.miss_noise < 0.0) {
+                    printf("%8s", "n/a");
+                }
+                else {
+                    printf("%8.3f", result.miss_noise);
+                }
+                printf("  %6ldKB\n", result.rss_kb);
+            }
+        }
+    }
+
+    if(write_file != NULL) {
+        if(bench_write_edc(write_file, results)) {
+            fprintf(stderr, "could not write: %s\n", write_file);
+            return 2;
+        }
+        printf("wrote energy decay curves to: %s\n", write_file);
+    }
+    if(compare_file != NULL) {
+        fails = bench_compare_edc(compare_file, results);
+        if(fails < 0) {
+            fprintf(stderr, "could not read: %s\n", compare_file);
+            return 2;
+        }
+        if(fails) {
+            printf("%d settings out of tolerance\n", fails);
+            return 1;
+        }
+        printf("all settings within %.2fdB\n", EDC_TOLERANCE);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Dintree V103 Reverb Delay Offload Check
+ *
+ * Written by: Andrew Kilpatrick
+ * Copyright 2020: Andrew Kilpatrick
+ *
+ * This file is part of Dintree-Virtual.
+ *
+ * Dintree-Virtual is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dintree-Virtual is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dintree-Virtual.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Runs V103 with the worker thread offload on and checks every block it
+ * plays against the same blocks run inline on a second instance. The
+ * periods are paced around the cost of a block so the worker is sometimes
+ * on time and sometimes late, and the handoffs between the worker and the
+ * engine thread happen as often as possible. A block may be played as
+ * silence if the worker missed it but it must never differ from the
+ * inline output.
+ *
+ * usage: v103_offload_check [periods]
+ *
+ */
+#include "v103_module.hpp"
+#include <chrono>
+
+#define CHECK_FS 48000
+#define CHECK_PERIODS 200000  // default number of block periods
+#define CHECK_LEVEL 5.0  // noise level in volts
+#define CHECK_REF_BLOCKS 8  // inline output blocks kept - must be a power of 2
+
+typedef std::chrono::steady_clock check_clock;
+
+// white noise from a fixed seed
+static float check_noise(uint32_t *seed) {
+    *seed = (*seed * 1664525) + 1013904223;
+    return ((int32_t)*seed / 2147483648.0f) * CHECK_LEVEL;
+}
+
+// spin for a number of ns
+static void check_spin(double ns) {
+    check_clock::time_point end = check_clock::now() +
+        std::chrono::duration_cast<check_clock::duration>(std::chrono::duration<double, std::nano>(ns));
+    while(check_clock::now() < end) {
+    }
+}
+
+// find out if a block played silence
+static int check_silent(const V103_OffloadBlock *block) {
+    int i;
+    for(i = 0; i < V103_OffloadBlock::LEN; i ++) {
+        if(block->outl[i] != 0.0f || block->outr[i] != 0.0f) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// compare the outputs of two blocks
+// returns 1 if they differ
+static int check_differ(const V103_OffloadBlock *a, const V103_OffloadBlock *b) {
+    return memcmp(a->outl, b->outl, sizeof(a->outl)) != 0 ||
+        memcmp(a->outr, b->outr, sizeof(a->outr)) != 0;
+}
+
+int main(int argc, char **argv) {
+    V103_Reverb_Delay *module, *ref;
+    V103_OffloadBlock block;
+    std::vector<V103_OffloadBlock> ref_out(CHECK_REF_BLOCKS);
+    Module::ProcessArgs args;
+    check_clock::time_point start;
+    double block_ns;
+    uint32_t seed = 12345, jitter = 1;
+    int periods, period, i, head, last_head, want;
+    int played = 0, silent = 0, dropped = 0, handoffs = 0, fails = 0;
+    int was_inline = 0;
+
+    periods = CHECK_PERIODS;
+    if(argc > 1) {
+        periods = atoi(argv[1]);
+    }
+
+    // denormals flush to zero on the Rack engine thread
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+
+    APP->engine->sampleRate = CHECK_FS;
+    args.sampleRate = CHECK_FS;
+    args.sampleTime = 1.0f / CHECK_FS;
+    args.frame = 0;
+    module = new V103_Reverb_Delay();
+    ref = new V103_Reverb_Delay();
+    module->inputs[V103_Reverb_Delay::INL].setChannels(1);
+    memset(&block, 0, sizeof(block));
+
+    // time a block on the inline instance to pace the periods
+    start = check_clock::now();
+    for(i = 0; i < 100; i ++) {
+        ref->offload_block(&block);
+    }
+    block_ns = std::chrono::duration<double, std::nano>(check_clock::now() - start).count() / 100.0;
+    delete ref;
+    ref = new V103_Reverb_Delay();
+
+    module->offload_set(1);
+    last_head = 0;
+    for(period = 0; period < periods; period ++) {
+        for(i = 0; i < V103_OffloadBlock::LEN; i ++) {
+            block.inl[i] = check_noise(&seed);
+            block.inr[i] = 0.0f;
+            module->inputs[V103_Reverb_Delay::INL].setVoltage(block.inl[i]);
+            module->process(args);
+            args.frame ++;
+        }
+
+        // run the block inline if it was posted
+        head = module->offload_head.load(std::memory_order_relaxed);
+        if(head == last_head) {
+            dropped ++;
+        }
+        else {
+            block.inr_conn = 0;
+            ref->offload_block(&block);
+            ref_out[last_head & (CHECK_REF_BLOCKS - 1)] = block;
+            last_head = head;
+        }
+
+        // check the block that will play next period
+        want = head - 2;
+        if(want >= 0) {
+            if(check_silent(&module->offload_play)) {
+                silent ++;
+            }
+            else if(check_differ(&module->offload_play, &ref_out[want & (CHECK_REF_BLOCKS - 1)])) {
+                if(fails < 10) {
+                    printf("offload block %d differs from the inline output\n", want);
+                }
+                fails ++;
+            }
+            else {
+                played ++;
+            }
+        }
+
+        // only pace the periods the worker has - the inline periods run
+        // flat out so the worker gets its blocks back sooner
+        if(module->offload_inline) {
+            was_inline = 1;
+            continue;
+        }
+        if(was_inline) {
+            handoffs ++;
+            was_inline = 0;
+        }
+        jitter = (jitter * 1664525) + 1013904223;
+        check_spin(block_ns * (0.5 + (jitter >> 8) / 16777216.0));
+    }
+    module->offload_set(0);
+
+    printf("offload periods: %d  played: %d  silent: %d  dropped: %d  handoffs: %d\n",
+        periods, played, silent, dropped, handoffs);
+    delete module;
+    delete ref;
+    if(fails) {
+        printf("%d offload blocks differ from the inline output\n", fails);
+        return 1;
+    }
+    printf("offload output matches the inline output\n");
+    return 0;
+}
@@ -23,7 +23,309 @@
 #include "plugin.hpp"
 #include "utils/KAComponents.h"
 #include "utils/MenuHelper.h"
+#include "utils/JsonHelper.h"
+#include "utils/DspUtils2.h"
 #include "dsp_utils.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <errno.h>
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
+// delay memory block - the reverb tank and the echo are kept in separate
+// rings so the small tank stays in cache while the echo streams past it
+struct V103_DelayBlock {
+    void *dmem;  // reverb tank memory
+    int dlen;  // reverb tank memory length (must be a power of 2)
+    void *emem;  // echo memory
+    int elen;  // echo memory length (must be a power of 2)
+    int mem16;  // 1 = 16 bit tank storage, 0 = float tank storage
+    int emem16;  // 1 = 16 bit echo storage, 0 = float echo storage
+    int groups;  // number of interleaved 4 voice groups - 0 = mono
+    V103_DelayBlock *next;  // link for the retired list
+};
+
+// counting semaphore - post() never blocks so the engine thread can
+// wake a worker without taking a lock
+struct V103_Semaphore {
+#if defined(__APPLE__)
+    dispatch_semaphore_t sem;
+
+    V103_Semaphore() {
+        sem = dispatch_semaphore_create(0);
+    }
+
+    ~V103_Semaphore() {
+        dispatch_release(sem);
+    }
+
+    void post(void) {
+        dispatch_semaphore_signal(sem);
+    }
+
+    void wait(void) {
+        dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
+    }
+#else
+    sem_t sem;
+
+    V103_Semaphore() {
+        sem_init(&sem, 0, 0);
+    }
+
+    ~V103_Semaphore() {
+        sem_destroy(&sem);
+    }
+
+    void post(void) {
+        sem_post(&sem);
+    }
+
+    void wait(void) {
+        while(sem_wait(&sem) != 0 && errno == EINTR) { }
+    }
+#endif
+};
+
+// delay memory allocator - allocating and zeroing several MB is too slow
+// for the engine thread, so all of that is done on a worker thread and the
+// engine thread only swaps pointers
+// one worker thread is shared by every instance and serves their requests
+// in order - it is started when the first instance is created
+// the engine thread side never takes a lock - requests and retired blocks
+// are pushed with atomics and the worker is woken with a semaphore
+struct V103_DelayAllocator {
+    // shared worker thread
+    struct Worker {
+        std::thread thread;
+        std::mutex lock;  // held by the worker while it serves requests
+        V103_Semaphore sem;  // wakes the worker
+        std::atomic<int> running;  // 0 = the worker should exit
+        std::atomic<V103_DelayAllocator *> pending;  // allocators with a new request - newest first
+        std::atomic<V103_DelayBlock *> retired;  // list of blocks waiting to be freed
+        V103_DelayAllocator *queue_head;  // requests to serve in order (protected by lock)
+        V103_DelayAllocator *queue_tail;  // last allocator on the queue (protected by lock)
+
+        Worker() : running(1), pending(NULL), retired(NULL) {
+            queue_head = NULL;
+            queue_tail = NULL;
+            thread = std::thread(&Worker::run, this);
+        }
+
+        ~Worker() {
+            running = 0;
+            sem.post();
+            thread.join();
+            destroy(retired.exchange(NULL));
+        }
+
+        // move the pending allocators onto the end of the queue in the
+        // order they were pushed - lock must be held
+        void drain(void) {
+            V103_DelayAllocator *alloc, *next, *list = NULL;
+            alloc = pending.exchange(NULL, std::memory_order_acquire);
+            while(alloc != NULL) {
+                next = alloc->queue_next;
+                alloc->queue_next = list;
+                list = alloc;
+                alloc = next;
+            }
+            if(list == NULL) {
+                return;
+            }
+            if(queue_tail != NULL) {
+                queue_tail->queue_next = list;
+            }
+            else {
+                queue_head = list;
+            }
+            while(list->queue_next != NULL) {
+                list = list->queue_next;
+            }
+            queue_tail = list;
+        }
+
+        // remove an allocator from the queue - lock must be held
+        void unqueue(V103_DelayAllocator *alloc) {
+            V103_DelayAllocator **link = &queue_head;
+            queue_tail = NULL;
+            while(*link != NULL) {
+                if(*link == alloc) {
+                    *link = alloc->queue_next;
+                    continue;
+                }
+                queue_tail = *link;
+                link = &(*link)->queue_next;
+            }
+            alloc->queue_next = NULL;
+        }
+
+        // worker thread
+        void run(void) {
+            V103_DelayAllocator *alloc;
+            V103_DelayBlock *block;
+            int req;
+            while(1) {
+                sem.wait();
+                if(!running) {
+                    break;
+                }
+                destroy(retired.exchange(NULL, std::memory_order_acquire));
+                std::lock_guard<std::mutex> lk(lock);
+                drain();
+                while(queue_head != NULL) {
+                    alloc = queue_head;
+                    queue_head = alloc->queue_next;
+                    if(queue_head == NULL) {
+                        queue_tail = NULL;
+                    }
+                    alloc->queue_next = NULL;
+                    // a request made from here on queues the allocator again
+                    alloc->queued.store(0);
+                    req = alloc->req.load();
+                    block = create(1 << (req & 0x1f), 1 << ((req >> 5) & 0x1f),
+                        (req >> 10) & 0x1, (req >> 11) & 0x1, (req >> 12) & 0x7);
+                    // a block that was never taken is stale now
+                    destroy(alloc->ready.exchange(block, std::memory_order_acq_rel));
+                }
+            }
+        }
+    };
+
+    std::atomic<V103_DelayBlock *> ready;  // newly allocated block waiting to be taken
+    std::atomic<int> req;  // newest request packed by request()
+    std::atomic<int> queued;  // 1 = waiting to be served by the worker
+    V103_DelayAllocator *queue_next;  // link for the pending list and the request queue
+
+    V103_DelayAllocator() : ready(NULL), req(0), queued(0) {
+        queue_next = NULL;
+        // start the worker here and not on the engine thread
+        worker();
+    }
+
+    // the engine must not be running this instance any more
+    ~V103_DelayAllocator() {
+        Worker &w = worker();
+        {
+            std::lock_guard<std::mutex> lk(w.lock);
+            w.drain();
+            w.unqueue(this);
+        }
+        destroy(ready.exchange(NULL));
+    }
+
+    // get the shared worker - created the first time it is needed
+    static Worker &worker(void) {
+        static Worker w;
+        return w;
+    }
+
+    // allocate a zeroed block - not for use on the engine thread
+    // voice groups are interleaved so each address holds a float_4
+    // large blocks come from the OS as untouched zero pages so a long echo
+    // only takes up memory as it is written
+    static V103_DelayBlock *create(int dlen, int elen, int mem16, int emem16, int groups) {
+        V103_DelayBlock *block = new V103_DelayBlock;
+        int lanes = groups ? groups * 4 : 1;
+        block->dmem = calloc(dlen * lanes, mem16 ? sizeof(int16_t) : sizeof(float));
+        block->dlen = dlen;
+        block->emem = calloc(elen * lanes, emem16 ? sizeof(int16_t) : sizeof(float));
+        block->elen = elen;
+        block->mem16 = mem16;
+        block->emem16 = emem16;
+        block->groups = groups;
+        block->next = NULL;
+        return block;
+    }
+
+    // free a list of blocks - not for use on the engine thread
+    static void destroy(V103_DelayBlock *block) {
+        V103_DelayBlock *next;
+        while(block != NULL) {
+            next = block->next;
+            free(block->dmem);
+            free(block->emem);
+            delete block;
+            block = next;
+        }
+    }
+
+    // request a new block with tank and echo lengths in samples
+    // the lengths must be powers of 2 - the newest request wins
+    void request(int dlen, int elen, int mem16, int emem16, int groups) {
+        Worker &w = worker();
+        V103_DelayAllocator *head;
+        // lengths as log2 in bits 0-9, then the storage types and groups
+        req.store(__builtin_ctz(dlen) | (__builtin_ctz(elen) << 5) |
+            (mem16 << 10) | (emem16 << 11) | (groups << 12));
+        if(queued.exchange(1)) {
+            return;
+        }
+        head = w.pending.load(std::memory_order_relaxed);
+        do {
+            queue_next = head;
+        } while(!w.pending.compare_exchange_weak(head, this,
+            std::memory_order_release, std::memory_order_relaxed));
+        w.sem.post();
+    }
+
+    // take the most recently allocated block if there is one
+    // returns NULL if nothing is ready
+    V103_DelayBlock *take(void) {
+        if(ready.load(std::memory_order_relaxed) == NULL) {
+            return NULL;
+        }
+        return ready.exchange(NULL, std::memory_order_acquire);
+    }
+
+    // hand a block back to be freed on the worker thread
+    void retire(V103_DelayBlock *block) {
+        Worker &w = worker();
+        V103_DelayBlock *head;
+        head = w.retired.load(std::memory_order_relaxed);
+        do {
+            block->next = head;
+        } while(!w.retired.compare_exchange_weak(head, block,
+            std::memory_order_release, std::memory_order_relaxed));
+        w.sem.post();
+    }
+};
+
+// block of samples passed to and from the offload worker
+struct V103_OffloadBlock {
+    static constexpr int LEN = 32;  // samples per block
+    float inl[LEN];
+    float inr[LEN];
+    float outl[LEN];
+    float outr[LEN];
+    int inr_conn;  // 1 = INR is connected
+};
+
+// delay memory access for the stereo tank - float or 16 bit storage
+inline float v103_mem_read(const float *mem, int addr) {
+    return mem[addr];
+}
+
+inline float v103_mem_read(const int16_t *mem, int addr) {
+    return dsp2::DelayStorage16::load(mem[addr]);
+}
+
+inline void v103_mem_write(float *mem, int addr, float in) {
+    mem[addr] = in;
+}
+
+inline void v103_mem_write(int16_t *mem, int addr, float in) {
+    mem[addr] = dsp2::DelayStorage16::store(in);
+}
+
+// add up the lanes of a float_4
+inline float v103_hsum(simd::float_4 in) {
+    return (in[0] + in[1]) + (in[2] + in[3]);
+}
 
 struct V103_Reverb_Delay : Module {
     enum ParamIds {
@@ -59,15 +361,61 @@ struct V103_Reverb_Delay : Module {
         REV_COEFF_DEL2,
         REV_COEFF_LPF_CUTOFF,
         REV_COEFF_HPF_CUTOFF,
-        REV_COEFF_ECHO
+        REV_COEFF_ECHO,
+        REV_COEFF_FDN1,
+        REV_COEFF_FDN2,
+        REV_COEFF_FDN3,
+        REV_COEFF_FDN4
+    };
+    enum {
+        ECHO_TAPS_PANEL,
+        ECHO_TAPS_SPREAD,
+        ECHO_TAPS_PINGPONG,
+        ECHO_TAPS_NUM
+    };
+    enum {
+        DEL_LONG_OFF,
+        DEL_LONG_5S,
+        DEL_LONG_30S,
+        DEL_LONG_120S,
+        DEL_LONG_NUM
+    };
+    enum {
+        OFFLOAD_OWNER_NONE,
+        OFFLOAD_OWNER_ENGINE,
+        OFFLOAD_OWNER_WORKER
+    };
+    enum {
+        SLEEP_FLOOR_OFF,
+        SLEEP_FLOOR_96DB,
+        SLEEP_FLOOR_120DB,
+        SLEEP_FLOOR_144DB,
+        SLEEP_FLOOR_NUM
     };
 
     #define RT_TASK_RATE 100.0
     #define METER_SMOOTHING 0.9999
+    #define REV_TANK_LEN_MAX (553 + 922 + 122 + 303 + 2062 + 3375 + 2500 + 2250)  // BIG layout at 32768Hz
+    #define REV_TANK_LINES 8
+    #define ECHO_TIME 0.5  // seconds
+    #define ECHO_TIME_MAX 120.0  // longest long delay in seconds
+    #define ECHO_TAPS_MAX 16
+    #define SLEEP_REF_LEVEL 5.0  // 0dBFS level in volts
+    #define MEM16_RANGE 16.0  // full scale of 16 bit memory in volts
+    #define REV_DESIGN_FS 32768  // samplerate the reverb was designed for
+    #define REV_STEREO_SPREAD 17  // extra samples on each right tank line at 32768Hz
+    #define POLY_GROUPS_MAX 4  // 16 voices in groups of 4
+    #define FDN_LINES 4
+    #define FDN_DAMP_FREQ 6000.0  // FDN line damping cutoff
+    #define OFFLOAD_LATENCY (V103_OffloadBlock::LEN * 2)  // added latency in samples
+    #define OFFLOAD_SLOTS 4  // blocks in flight - must be a power of 2
+    #define OFFLOAD_RESUME 1024  // on-time inline periods before the worker gets blocks again
 
     dsp::ClockDivider task_timer;
     // settings
     int AUDIO_FS;
+    int REV_FS;  // samplerate the reverb tank runs at
+    int rate_div;  // AUDIO_FS / REV_FS
     // delay line coeffs
     int api1_in;
     int api1;
@@ -87,6 +435,10 @@ struct V103_Reverb_Delay : Module {
     int del2;
     int echo_in;
     int echo;
+    int fdn_in[FDN_LINES];  // FDN lines share the tank memory after the input allpasses
+    int fdn[FDN_LINES];
+    int fdn_len[FDN_LINES];
+    int rev_loop;  // length of the figure-eight tank loop
     // filter coeffs
     float lfilt_a0;
     float hfilt_a0;
@@ -102,11 +454,90 @@ struct V103_Reverb_Delay : Module {
     float del_synco;
     float del_synco_t1;
     float del_synco_t2;
+    int echo_taps;  // echo tap pattern setting
+    int tap_num;  // number of taps in use - multiple of 4
+    float tap_time[ECHO_TAPS_MAX];  // tap time relative to the delay time
+    float tap_gain[ECHO_TAPS_MAX];
+    float tap_pan[ECHO_TAPS_MAX];  // -1.0 = left, 0.0 = center, +1.0 = right
+    float tap_send[ECHO_TAPS_MAX];  // feedback send
+    simd::float_4 tap_gl[ECHO_TAPS_MAX / 4];  // left gain including the mix
+    simd::float_4 tap_gr[ECHO_TAPS_MAX / 4];  // right gain including the mix
+    simd::float_4 tap_fb[ECHO_TAPS_MAX / 4];  // feedback gain
+    int sleep_floor;  // sleep floor setting
+    int mem16;  // 16 bit memory setting
+    int del_long;  // long delay setting
+    int del_long_cur;  // long delay setting in use
+    float echo_time;  // echo length in use in seconds
+    int int_rate;  // internal rate setting
+    int int_rate_cur;  // internal rate setting in use
+    int stereo;  // true stereo setting
+    int stereo_cur;  // true stereo setting in use
+    int fdn_rev;  // FDN reverb setting
+    int fdn_rev_cur;  // FDN reverb setting in use
+    int offload;  // worker thread offload setting
     // state
-    #define DMEM_SIZE (1024*1024)
-    float dmem[DMEM_SIZE];
-    int dlen;  // delay memory length (must be a power of 2)
-    int dp;  // delay memory pointer
+    V103_DelayAllocator dmem_alloc;
+    V103_DelayBlock *dmem_block;  // block holding dmem and emem
+    float *dmem;  // reverb tank memory
+    int dlen;  // reverb tank memory length (must be a power of 2)
+    int dp;  // reverb tank memory pointer
+    float *emem;  // echo memory
+    int elen;  // echo memory length (must be a power of 2)
+    int ep;  // echo memory pointer
+    int dmem_need;  // tank memory length needed at the current samplerate
+    int emem_need;  // echo memory length needed at the current samplerate
+    int dmem_used;  // 1 = delay memory has been written since it was installed
+    int dmem_wait;  // 1 = waiting for fresh zeroed delay memory
+    int dmem_mem16;  // 1 = installed tank memory is 16 bit
+    int dmem_emem16;  // 1 = installed echo memory is 16 bit
+    int dmem_req_mem16;  // storage type of the newest request
+    int dmem_groups;  // voice groups in the installed memory - 0 = mono
+    int poly_groups;  // voice groups needed for the input channels - 0 = mono
+    dsp2::DelayLine<dsp2::DelayStorage16> tank16;  // reverb tank when using 16 bit memory
+    dsp2::DelayLine<dsp2::DelayStorage16> echo16;  // echo when using 16 bit memory
+    // true stereo tank addresses - lanes 0/1 are the two halves of the
+    // left tank and lanes 2/3 are the two halves of the right tank
+    // the input allpasses are shared by both halves so they only have
+    // a left and a right address
+    int st_api_in[4][2];
+    int st_api[4][2];
+    int st_xread[4];  // the other half's delay output
+    int st_ap_in[4];
+    int st_ap[4];
+    int st_del_in[4];
+    int st_end;  // end of the stereo layout
+    simd::float_4 st_lfilt_z1;
+    simd::float_4 st_hfilt_z1;
+    // FDN state - one lane per line
+    simd::float_4 fdn_gain;
+    simd::float_4 fdn_z1;
+    float fdn_damp;
+    // polyphonic voice state - one float_4 per group of 4 voices
+    simd::float_4 poly_lfilt_z1[POLY_GROUPS_MAX];
+    simd::float_4 poly_hfilt_z1[POLY_GROUPS_MAX];
+    simd::float_4 poly_feedback[POLY_GROUPS_MAX];
+    simd::float_4 poly_del_lp_z1[POLY_GROUPS_MAX];
+    // worker thread offload - the network state belongs to whichever
+    // thread holds offload_owner and blocks are run strictly in order, so
+    // the engine can claim a late block without waiting for the worker
+    std::thread offload_thread;  // only running while the offload setting is on
+    V103_Semaphore offload_sem;  // wakes the worker
+    std::atomic<int> offload_running;  // 0 = the worker should exit
+    std::atomic<int> offload_owner;  // thread running the network
+    std::atomic<int> offload_hold;  // 1 = the worker must not claim blocks
+    std::atomic<int> offload_head;  // blocks posted by the engine
+    std::atomic<int> offload_tail;  // blocks finished by either thread
+    V103_OffloadBlock offload_slots[OFFLOAD_SLOTS];
+    int offload_cur;  // 1 = blocks are being posted
+    int offload_inline;  // periods left to run inline after a missed deadline
+    int offload_pos;  // sample position in the blocks
+    V103_OffloadBlock offload_fill;  // block being filled
+    V103_OffloadBlock offload_play;  // block being played
+    // internal rate resampling
+    dsp2::PolyphaseDecimator rev_dec;
+    dsp2::PolyphaseDecimator rev_decr;
+    dsp2::PolyphaseInterpolator rev_interpl;
+    dsp2::PolyphaseInterpolator rev_interpr;
     // working regs
     float lfilt_z1;
     float hfilt_z1;
@@ -114,8 +545,13 @@ struct V103_Reverb_Delay : Module {
     float feedback_samp;
     int del_len;
     int del_lp_z1;
+    float sleep_level;  // tail level to sleep below - 0.0 = never sleep
+    int sleep_len;  // quiet samples needed to flush all delay memory
+    int quiet_count;  // number of samples the input and tails have been quiet
+    int sleeping;  // 1 = network is asleep
 
-    V103_Reverb_Delay() {
+    V103_Reverb_Delay() : offload_running(0), offload_owner(OFFLOAD_OWNER_ENGINE),
+            offload_hold(1), offload_head(0), offload_tail(0) {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         configParam(POT_REV_MIX, 0.f, 1.f, 0.f, "REVERB MIX");
         configParam(POT_DEL_MIX, 0.f, 1.f, 0.f, "DELAY MIX");
@@ -126,23 +562,126 @@ struct V103_Reverb_Delay : Module {
         configInput(INR, "IN R");
         configOutput(OUTL, "OUT L");
         configOutput(OUTR, "OUT R");        
+        // we are not on the engine thread yet so allocate right here
+        dmem_block = NULL;
+        dmem_wait = 0;
+        mem16 = 0;
+        del_long = DEL_LONG_OFF;
+        del_long_cur = DEL_LONG_OFF;
+        echo_taps = ECHO_TAPS_PANEL;
+        echo_time = ECHO_TIME;
+        int_rate = 0;
+        stereo = 0;
+        stereo_cur = 0;
+        fdn_rev = 0;
+        fdn_rev_cur = 0;
+        offload = 0;
+        offload_cur = 0;
+        offload_inline = 0;
+        poly_groups = 0;
+        dmem_req_mem16 = mem16;
+        dmem_install(V103_DelayAllocator::create(dmem_calc_len((int)APP->engine->getSampleRate()),
+            emem_calc_len((int)APP->engine->getSampleRate()), mem16, emem_calc_mem16(), poly_groups));
         // reset stuff
         onReset();
         onSampleRateChange();
         setParams();
     }
 
+    ~V103_Reverb_Delay() {
+        offload_stop();
+        V103_DelayAllocator::destroy(dmem_block);
+    }
+
     // process a sample
     void process(const ProcessArgs& args) override {
-        float inlr, outl, outr, tempf;
-        float klow, khigh, kpass;  // filter mixing coeffs
-        float acc, temp1, apout, it1, lpout, hpout;
+        float outl, outr;
+        int chans, c;
+
+        // the worker only runs the mono network
+        chans = DSP_UTILS_MAX(inputs[INL].getChannels(), inputs[INR].getChannels());
+        if(offload && chans < 2) {
+            if(!offload_cur) {
+                offload_attach();
+            }
+            offload_process();
+            return;
+        }
+        // the worker is still running a block so stay quiet until it is done
+        if(offload_cur && offload_detach(0)) {
+            outputs[OUTL].setVoltage(0.0f);
+            outputs[OUTR].setVoltage(0.0f);
+            return;
+        }
 
         // state
         if(task_timer.process()) {
             setParams();
         }
 
+        if(dmem_groups) {
+            chans = DSP_UTILS_CLAMP_RANGE(chans, 1, dmem_groups * 4);
+        }
+        else {
+            chans = 1;
+        }
+        outputs[OUTL].setChannels(chans);
+        outputs[OUTR].setChannels(chans);
+
+        // delay memory for this samplerate is still being allocated
+        if(dmem_wait || dlen < dmem_need || elen < emem_need ||
+                dmem_groups != poly_groups) {
+            for(c = 0; c < chans; c ++) {
+                outputs[OUTL].setVoltage(0.0f, c);
+                outputs[OUTR].setVoltage(0.0f, c);
+            }
+            return;
+        }
+
+        // polyphonic input
+        if(dmem_groups) {
+            process_poly(chans);
+            return;
+        }
+
+        process_mono(inputs[INL].getVoltage(), inputs[INR].getVoltage(),
+            inputs[INR].isConnected(), &outl, &outr);
+        outputs[OUTL].setVoltage(outl);
+        outputs[OUTR].setVoltage(outr);
+    }
+
+    // process a mono sample
+    // inl / inr - the input voltages
+    // inr_conn - 1 = INR is connected
+    // lout / rout - the output voltages
+    void process_mono(float inl, float inr, int inr_conn, float *lout, float *rout) {
+        float inlr, outl, outr, tempf;
+        float revl, revr;
+        float klow, khigh, kpass;  // filter mixing coeffs
+        float acc, lpout, hpout;
+        float tapl, tapr, tapfb;
+        simd::float_4 acc4, lpout4, hpout4;
+
+        inl *= 0.75;
+        inr *= 0.75;
+        inlr = inl + inr;
+
+        // the tails are below the floor so skip the network until
+        // the input comes back - memory holds only sub-floor values
+        // so waking up again can't click
+        if(sleeping) {
+            tempf = DSP_UTILS_MAX(DSP_UTILS_ABS(inl), DSP_UTILS_ABS(inr));
+            if(tempf < sleep_level) {
+                *lout = 0.0f;
+                *rout = 0.0f;
+                return;
+            }
+            sleeping = 0;
+            quiet_count = 0;
+        }
+
+        dmem_used = 1;
+
         // smooth time
         DSP_UTILS_F1LP(params[POT_DEL_TIME].getValue(), tempf, 0.999999999, del_time);
 
@@ -152,78 +691,502 @@ struct V103_Reverb_Delay : Module {
         kpass = 1.0 - DSP_UTILS_ABS((filter * 2.0) - 1.0);
 
         // process reverb
-        // rotate delay mem
-        DSP_UTILS_DROT(dp, dlen);
-
-        inlr = inputs[INL].getVoltage() * 0.75;
-        inlr += inputs[INR].getVoltage() * 0.75;
+        // rotate echo mem - the tank rotates at its own rate
+        if(dmem_emem16) {
+            echo16.rotate();
+        }
+        else {
+            DSP_UTILS_DROT(ep, elen);
+        }
 
         // delay in
-        DSP_UTILS_DWRITE(dmem, dp, dlen, echo_in, inlr + feedback_samp);
-
-        // reverb
-        DSP_UTILS_F1LP(inlr, lpout, lfilt_a0, lfilt_z1);
-        DSP_UTILS_F1HP(inlr, hpout, hfilt_a0, hfilt_z1);
-        acc = lpout * klow;
-        acc += hpout * khigh;
-        acc += inlr * kpass;
-
-        DSP_UTILS_AP(dmem, dp, dlen, api1_in, api1, kap);
-        DSP_UTILS_AP(dmem, dp, dlen, api2_in, api2, kap);
-        DSP_UTILS_AP(dmem, dp, dlen, api3_in, api3, kap);
-        DSP_UTILS_AP(dmem, dp, dlen, api4_in, api4, kap);
-        apout = acc;
+        if(dmem_emem16) {
+            echo16.write(echo_in, (inlr + feedback_samp) * (float)(1.0 / MEM16_RANGE));
+        }
+        else {
+            DSP_UTILS_DWRITE(emem, ep, elen, echo_in, inlr + feedback_samp);
+        }
 
-        DSP_UTILS_DREAD(dmem, dp, dlen, del2, temp1);
-        acc += temp1;
-        acc *= krt;
-        DSP_UTILS_AP(dmem, dp, dlen, ap1_in, ap1, kap);
-        DSP_UTILS_DWRITE(dmem, dp, dlen, del1_in, acc);
-        outl = acc;
+        // true stereo reverb - both tanks run together in SIMD lanes
+        if(stereo_cur && !fdn_rev_cur) {
+            // right input is normalled to the left input
+            if(!inr_conn) {
+                inr = inl;
+            }
+            acc4 = simd::float_4(inl, inl, inr, inr) * 2.0f;
+            DSP_UTILS_F1LP(acc4, lpout4, lfilt_a0, st_lfilt_z1);
+            DSP_UTILS_F1HP(acc4, hpout4, hfilt_a0, st_hfilt_z1);
+            acc4 = (lpout4 * klow) + (hpout4 * khigh) + (acc4 * kpass);
+            if(rate_div > 1) {
+                // both decimators always run in step
+                rev_decr.process(acc4[2], &revr);
+                if(rev_dec.process(acc4[0], &revl)) {
+                    acc4 = simd::float_4(revl, revl, revr, revr);
+                    if(dmem_mem16) {
+                        tank_stereo_process(tank16.delay, &tank16.dp, tank16.dlen,
+                            (float)MEM16_RANGE, acc4, &outl, &outr);
+                    }
+                    else {
+                        tank_stereo_process(dmem, &dp, dlen, 1.0f, acc4, &outl, &outr);
+                    }
+                    rev_interpl.push(outl);
+                    rev_interpr.push(outr);
+                }
+                outl = rev_interpl.process();
+                outr = rev_interpr.process();
+            }
+            else if(dmem_mem16) {
+                tank_stereo_process(tank16.delay, &tank16.dp, tank16.dlen,
+                    (float)MEM16_RANGE, acc4, &outl, &outr);
+            }
+            else {
+                tank_stereo_process(dmem, &dp, dlen, 1.0f, acc4, &outl, &outr);
+            }
+        }
+        else {
+            // reverb
+            DSP_UTILS_F1LP(inlr, lpout, lfilt_a0, lfilt_z1);
+            DSP_UTILS_F1HP(inlr, hpout, hfilt_a0, hfilt_z1);
+            acc = lpout * klow;
+            acc += hpout * khigh;
+            acc += inlr * kpass;
 
-        acc = apout;
-        DSP_UTILS_DREAD(dmem, dp, dlen, del1, temp1);
-        acc += temp1;
-        acc *= krt;
-        DSP_UTILS_AP(dmem, dp, dlen, ap2_in, ap2, kap);
-        DSP_UTILS_DWRITE(dmem, dp, dlen, del2_in, acc);
-        outr = acc;
+            // run the tank at the internal rate
+            if(rate_div > 1) {
+                if(rev_dec.process(acc, &acc)) {
+                    mono_tank_process(acc, &outl, &outr);
+                    rev_interpl.push(outl);
+                    rev_interpr.push(outr);
+                }
+                outl = rev_interpl.process();
+                outr = rev_interpr.process();
+            }
+            else {
+                mono_tank_process(acc, &outl, &outr);
+            }
+        }
+
+        // track the tank and echo feedback path levels
+        tempf = DSP_UTILS_ABS(inlr + feedback_samp);
+        if(stereo_cur) {
+            tempf = DSP_UTILS_MAX(DSP_UTILS_MAX(DSP_UTILS_ABS(inl), DSP_UTILS_ABS(inr)), tempf);
+        }
+        tempf = DSP_UTILS_MAX(DSP_UTILS_ABS(outl), tempf);
+        tempf = DSP_UTILS_MAX(DSP_UTILS_ABS(outr), tempf);
+        if(tempf > sleep_level) {
+            quiet_count = 0;
+        }
+        else {
+            quiet_count ++;
+            if(quiet_count > sleep_len && sleep_level > 0.0f) {
+                sleeping = 1;
+            }
+        }
 
         outl *= rev_mix;
         outr *= rev_mix;
 
-        DSP_UTILS_DREADF(dmem, dp, dlen, (float)echo_in + ((float)del_len * del_time), tempf);
-        outl += tempf * del_mix;
-        outr += tempf * del_mix;
-
-        DSP_UTILS_DREADF(dmem, dp, dlen, (float)echo_in + ((float)del_len * del_time * del_synco_t1), tempf);
-        outl += tempf * del_mix * del_synco;
-
-        DSP_UTILS_DREADF(dmem, dp, dlen, (float)echo_in + ((float)del_len * del_time * del_synco_t2), tempf);
-        outr += tempf * del_mix * del_synco;
+        if(dmem_emem16) {
+            echo_taps_process(echo16.delay, echo16.dp, echo16.dlen, (float)MEM16_RANGE,
+                &tapl, &tapr, &tapfb);
+        }
+        else {
+            echo_taps_process(emem, ep, elen, 1.0f, &tapl, &tapr, &tapfb);
+        }
+        outl += tapl;
+        outr += tapr;
 
-        tempf *= 0.4;
-        DSP_UTILS_F1LP(tempf, feedback_samp, 0.6, del_lp_z1);
+        DSP_UTILS_F1LP(tapfb, feedback_samp, 0.6, del_lp_z1);
 
         tempf = DSP_UTILS_ABS(outl);
         tempf = DSP_UTILS_MAX(DSP_UTILS_ABS(outr), tempf);
         DSP_UTILS_LMM(tempf, peak, METER_SMOOTHING);
 
-        outputs[OUTL].setVoltage(outl);
-        outputs[OUTR].setVoltage(outr);
+        *lout = outl;
+        *rout = outr;
+    }
+
+    // process polyphonic input - the voices run four at a time in
+    // float_4 lanes and each group's memory is interleaved so one
+    // rotate and one address serve all four voices
+    // always uses float memory at the full samplerate with a mono tank
+    // chans - the number of voices to output
+    void process_poly(int chans) {
+        simd::float_4 inlr[POLY_GROUPS_MAX];
+        simd::float_4 acc, lpout, hpout, outl, outr, temp4, level;
+        simd::float_4 tap, fb;
+        simd::float_4 *tank, *echo;
+        float klow, khigh, kpass, tempf;
+        float fract[ECHO_TAPS_MAX];
+        int addr[ECHO_TAPS_MAX];
+        int g, groups, c, k;
+
+        groups = (chans + 3) / 4;
+        level = 0.0f;
+        for(g = 0; g < groups; g ++) {
+            inlr[g] = (inputs[INL].getPolyVoltageSimd<simd::float_4>(g * 4) +
+                inputs[INR].getPolyVoltageSimd<simd::float_4>(g * 4)) * 0.75f;
+            level = simd::fmax(simd::abs(inlr[g]), level);
+        }
+
+        // sleep until any voice comes back
+        if(sleeping) {
+            tempf = DSP_UTILS_MAX(DSP_UTILS_MAX(level[0], level[1]), DSP_UTILS_MAX(level[2], level[3]));
+            if(tempf < sleep_level) {
+                for(c = 0; c < chans; c ++) {
+                    outputs[OUTL].setVoltage(0.0f, c);
+                    outputs[OUTR].setVoltage(0.0f, c);
+                }
+                return;
+            }
+            sleeping = 0;
+            quiet_count = 0;
+        }
+
+        dmem_used = 1;
+
+        // smooth time
+        DSP_UTILS_F1LP(params[POT_DEL_TIME].getValue(), tempf, 0.999999999, del_time);
+
+        // filter mixing coeffs
+        khigh = DSP_UTILS_CLAMP_POS((filter - 0.5) * 2.0);
+        klow = DSP_UTILS_CLAMP_POS((1.0 - (filter * 2.0)));
+        kpass = 1.0 - DSP_UTILS_ABS((filter * 2.0) - 1.0);
+
+        // every voice shares the same pointers and taps
+        DSP_UTILS_DROT(dp, dlen);
+        DSP_UTILS_DROT(ep, elen);
+        for(k = 0; k < tap_num; k ++) {
+            fract[k] = echo_tap_addr(k, &addr[k]);
+            addr[k] += ep + echo_in;
+        }
+
+        level = 0.0f;
+        tempf = 0.0f;
+        for(g = 0; g < groups; g ++) {
+            tank = (simd::float_4 *)dmem + (g * dlen);
+            echo = (simd::float_4 *)emem + (g * elen);
+
+            // delay in
+            temp4 = inlr[g] + poly_feedback[g];
+            DSP_UTILS_DWRITE(echo, ep, elen, echo_in, temp4);
+            level = simd::fmax(simd::abs(temp4), level);
+
+            // reverb
+            DSP_UTILS_F1LP(inlr[g], lpout, lfilt_a0, poly_lfilt_z1[g]);
+            DSP_UTILS_F1HP(inlr[g], hpout, hfilt_a0, poly_hfilt_z1[g]);
+            acc = (lpout * klow) + (hpout * khigh) + (inlr[g] * kpass);
+            tank_process(tank, acc, &outl, &outr);
+            level = simd::fmax(simd::abs(outl), level);
+            level = simd::fmax(simd::abs(outr), level);
+
+            outl *= rev_mix;
+            outr *= rev_mix;
+
+            // each tap read covers four voices
+            fb = 0.0f;
+            for(k = 0; k < tap_num; k ++) {
+                tap = echo[addr[k] & (elen - 1)];
+                tap += (echo[(addr[k] + 1) & (elen - 1)] - tap) * fract[k];
+                outl += tap * tap_gl[k / 4][k % 4];
+                outr += tap * tap_gr[k / 4][k % 4];
+                fb += tap * tap_fb[k / 4][k % 4];
+            }
+
+            // the state is whole volts like the mono feedback filter
+            temp4 = fb;
+            poly_del_lp_z1[g] = simd::trunc(((temp4 - poly_del_lp_z1[g]) * 0.6f) + poly_del_lp_z1[g]);
+            poly_feedback[g] = poly_del_lp_z1[g];
+
+            outputs[OUTL].setVoltageSimd(outl, g * 4);
+            outputs[OUTR].setVoltageSimd(outr, g * 4);
+
+            temp4 = simd::fmax(simd::abs(outl), simd::abs(outr));
+            for(c = 0; c < 4 && (g * 4) + c < chans; c ++) {
+                tempf = DSP_UTILS_MAX(temp4[c], tempf);
+            }
+        }
+        DSP_UTILS_LMM(tempf, peak, METER_SMOOTHING);
+
+        // track the tank and echo feedback path levels
+        tempf = DSP_UTILS_MAX(DSP_UTILS_MAX(level[0], level[1]), DSP_UTILS_MAX(level[2], level[3]));
+        if(tempf > sleep_level) {
+            quiet_count = 0;
+        }
+        else {
+            quiet_count ++;
+            if(quiet_count > sleep_len && sleep_level > 0.0f) {
+                sleeping = 1;
+            }
+        }
+    }
+
+    // run one sample of the mono network for the offload
+    // this runs on whichever thread owns the network state
+    void offload_frame(float inl, float inr, int inr_conn, float *outl, float *outr) {
+        if(task_timer.process()) {
+            setParams();
+        }
+        if(dmem_wait || dlen < dmem_need || elen < emem_need ||
+                dmem_groups != poly_groups || dmem_groups) {
+            *outl = 0.0f;
+            *outr = 0.0f;
+            return;
+        }
+        process_mono(inl, inr, inr_conn, outl, outr);
+    }
+
+    // run a whole block of the mono network
+    void offload_block(V103_OffloadBlock *block) {
+        int i;
+        for(i = 0; i < V103_OffloadBlock::LEN; i ++) {
+            offload_frame(block->inl[i], block->inr[i], block->inr_conn,
+                &block->outl[i], &block->outr[i]);
+        }
+    }
+
+    // move a sample through the offload blocks - the worker has one block
+    // period to finish each block so the output is OFFLOAD_LATENCY late
+    void offload_process(void) {
+        outputs[OUTL].setChannels(1);
+        outputs[OUTR].setChannels(1);
+        if(offload_pos == 0) {
+            offload_fill.inr_conn = inputs[INR].isConnected();
+        }
+        offload_fill.inl[offload_pos] = inputs[INL].getVoltage();
+        offload_fill.inr[offload_pos] = inputs[INR].getVoltage();
+        outputs[OUTL].setVoltage(offload_play.outl[offload_pos]);
+        outputs[OUTR].setVoltage(offload_play.outr[offload_pos]);
+        offload_pos ++;
+        if(offload_pos < V103_OffloadBlock::LEN) {
+            return;
+        }
+        offload_pos = 0;
+        offload_period();
+    }
+
+    // post the block from this period and take the block from the period
+    // before - the engine thread never waits for the worker
+    void offload_period(void) {
+        int head, tail, want;
+        head = offload_head.load(std::memory_order_relaxed);
+        tail = offload_tail.load(std::memory_order_acquire);
+        want = head - 1;
+
+        // late or running inline - take the network if the worker is not
+        // in the middle of a block and run what is left here
+        if(tail <= want) {
+            if(!offload_inline) {
+                offload_hold.store(1, std::memory_order_release);
+            }
+            if(offload_claim(OFFLOAD_OWNER_ENGINE)) {
+                offload_miss();
+                offload_post(head);
+                return;
+            }
+            // the worker may have finished a block before the claim
+            tail = offload_tail.load(std::memory_order_acquire);
+            while(tail <= want) {
+                offload_block(&offload_slots[tail & (OFFLOAD_SLOTS - 1)]);
+                tail ++;
+            }
+            offload_tail.store(tail, std::memory_order_release);
+            offload_owner.store(OFFLOAD_OWNER_NONE, std::memory_order_release);
+            if(!offload_inline) {
+                offload_inline = OFFLOAD_RESUME;
+            }
+        }
+        offload_post(head);
+        offload_play = offload_slots[want & (OFFLOAD_SLOTS - 1)];
+
+        // give the worker another go after enough on-time periods
+        if(offload_inline) {
+            offload_inline --;
+            if(offload_inline) {
+                return;
+            }
+            offload_hold.store(0, std::memory_order_release);
+        }
+        offload_sem.post();
+    }
+
+    // post the block from this period
+    // head - the number of blocks posted so far
+    void offload_post(int head) {
+        // the worker has been stuck on one block for the whole ring
+        if(head - offload_tail.load(std::memory_order_acquire) == OFFLOAD_SLOTS) {
+            return;
+        }
+        offload_slots[head & (OFFLOAD_SLOTS - 1)] = offload_fill;
+        offload_head.store(head + 1, std::memory_order_release);
+    }
+
+    // play silence for a period the worker could not finish in time
+    void offload_miss(void) {
+        memset(&offload_play, 0, sizeof(offload_play));
+        offload_hold.store(1, std::memory_order_release);
+        offload_inline = OFFLOAD_RESUME;
+    }
+
+    // try to take the network state
+    // returns -1 if another thread has it
+    int offload_claim(int owner) {
+        int temp = OFFLOAD_OWNER_NONE;
+        if(offload_owner.compare_exchange_strong(temp, owner,
+                std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return 0;
+        }
+        return temp == owner ? 0 : -1;
+    }
+
+    // hand the network to the worker
+    void offload_attach(void) {
+        memset(&offload_play, 0, sizeof(offload_play));
+        // the first two periods play silence
+        memset(offload_slots, 0, sizeof(offload_slots));
+        offload_pos = 0;
+        offload_inline = 0;
+        offload_head.store(0, std::memory_order_relaxed);
+        offload_tail.store(0, std::memory_order_relaxed);
+        offload_hold.store(0, std::memory_order_relaxed);
+        offload_owner.store(OFFLOAD_OWNER_NONE, std::memory_order_release);
+        offload_cur = 1;
+    }
+
+    // take the network back from the worker - blocks not run yet are dropped
+    // wait - 1 = wait for the worker to finish its block (not on the engine thread)
+    // returns -1 if the worker is still running a block
+    int offload_detach(int wait) {
+        if(!offload_cur) {
+            return 0;
+        }
+        offload_hold.store(1, std::memory_order_release);
+        while(offload_claim(OFFLOAD_OWNER_ENGINE)) {
+            if(!wait) {
+                return -1;
+            }
+            std::this_thread::yield();
+        }
+        offload_cur = 0;
+        return 0;
+    }
+
+    // start the worker thread - not for use on the engine thread
+    void offload_start(void) {
+        if(offload_thread.joinable()) {
+            return;
+        }
+        offload_running = 1;
+        offload_thread = std::thread(&V103_Reverb_Delay::offload_run, this);
+    }
+
+    // stop the worker thread - not for use on the engine thread
+    // if the engine is still posting blocks it runs them itself
+    void offload_stop(void) {
+        if(!offload_thread.joinable()) {
+            return;
+        }
+        offload_running = 0;
+        offload_sem.post();
+        offload_thread.join();
+    }
+
+    // change the offload setting - not for use on the engine thread
+    void offload_set(int val) {
+        if(val) {
+            offload_start();
+            offload = 1;
+        }
+        else {
+            offload = 0;
+            offload_stop();
+        }
+    }
+
+    // offload worker thread - it only runs when it is woken for a block
+    void offload_run(void) {
+        int tail;
+        while(1) {
+            offload_sem.wait();
+            if(!offload_running) {
+                break;
+            }
+            while(!offload_hold.load(std::memory_order_acquire) &&
+                    offload_claim(OFFLOAD_OWNER_WORKER) == 0) {
+                tail = offload_tail.load(std::memory_order_relaxed);
+                if(tail == offload_head.load(std::memory_order_acquire)) {
+                    offload_owner.store(OFFLOAD_OWNER_NONE, std::memory_order_release);
+                    break;
+                }
+                offload_block(&offload_slots[tail & (OFFLOAD_SLOTS - 1)]);
+                offload_tail.store(tail + 1, std::memory_order_release);
+                offload_owner.store(OFFLOAD_OWNER_NONE, std::memory_order_release);
+            }
+        }
     }
 
     // samplerate changed
     void onSampleRateChange(void) override {
+        // the engine is stopped but the worker may still be running
+        offload_detach(1);
         task_timer.setDivision((int)(APP->engine->getSampleRate() / RT_TASK_RATE));
         AUDIO_FS = (int)APP->engine->getSampleRate();
+        update_rates();
+    }
+
+    // work out the reverb tank rate and delay memory needs
+    void update_rates(void) {
+        int_rate_cur = int_rate;
+        stereo_cur = stereo;
+        del_long_cur = del_long;
+        poly_groups = poly_calc_groups();
+        // polyphonic voices keep the short echo
+        switch(poly_groups ? DEL_LONG_OFF : del_long_cur) {
+            case DEL_LONG_5S:
+                echo_time = 5.0;
+                break;
+            case DEL_LONG_30S:
+                echo_time = 30.0;
+                break;
+            case DEL_LONG_120S:
+                echo_time = ECHO_TIME_MAX;
+                break;
+            case DEL_LONG_OFF:
+            default:
+                echo_time = ECHO_TIME;
+                break;
+        }
+        rate_div = 1;
+        if(int_rate_cur && poly_groups == 0) {
+            rate_div = DSP_UTILS_CLAMP_RANGE(AUDIO_FS / REV_DESIGN_FS,
+                1, dsp2::PolyphaseDecimator::MAX_FACTOR);
+        }
+        REV_FS = AUDIO_FS / rate_div;
+        rev_dec.setFactor(rate_div);
+        rev_decr.setFactor(rate_div);
+        rev_interpl.setFactor(rate_div);
+        rev_interpr.setFactor(rate_div);
+        dmem_need = dmem_calc_len(REV_FS);
+        emem_need = emem_calc_len(AUDIO_FS);
+        if(dmem_wait || dlen != dmem_need || elen != emem_need ||
+                dmem_groups != poly_groups || dmem_emem16 != emem_calc_mem16()) {
+            dmem_request();
+        }
+        rev = -1;  // force the layout to be recalculated
+    }
+
+    // get the number of voice groups needed for the input channels
+    int poly_calc_groups(void) {
+        int chans = DSP_UTILS_MAX(inputs[INL].getChannels(), inputs[INR].getChannels());
+        if(chans < 2) {
+            return 0;
+        }
+        return DSP_UTILS_CLAMP_RANGE((chans + 3) / 4, 1, POLY_GROUPS_MAX);
     }
 
     // module initialize
     void onReset(void) override {
-        for(int i = 0; i < DMEM_SIZE; i ++) {
-            dmem[i] = 0.0f;
-        }
+        offload_detach(1);
         random::init();
         params[POT_REV_MIX].setValue(0.5);
         params[POT_DEL_MIX].setValue(0.5);
@@ -231,8 +1194,8 @@ struct V103_Reverb_Delay : Module {
         params[DEL_SW].setValue(2.0);
         params[REV_SW].setValue(1.0);
         rev = -1;
-        dlen = 1024*1024;
         dp = 0;
+        ep = 0;
         kap = 0.55;
         lfilt_z1 = 0.0;
         hfilt_z1 = 0.0;
@@ -241,12 +1204,92 @@ struct V103_Reverb_Delay : Module {
         feedback_samp = 0.0;
         del_len = 0;
         del_lp_z1 = 0.0;
+        sleep_floor = SLEEP_FLOOR_120DB;
+        mem16 = 0;
+        del_long = DEL_LONG_OFF;
+        echo_taps = ECHO_TAPS_PANEL;
+        int_rate = 0;
+        stereo = 0;
+        fdn_rev = 0;
+        offload_set(0);
+        st_lfilt_z1 = 0.0f;
+        st_hfilt_z1 = 0.0f;
+        poly_reset();
+        sleep_level = 0.0;
+        sleep_len = 0;
+        quiet_count = 0;
+        sleeping = 0;
+        // swap in fresh memory sized for the reset settings instead of
+        // zeroing the old memory here - the allocator gets new zero pages
+        // off the engine thread and the output is muted until they arrive
+        if(dmem_used) {
+            dmem_wait = 1;
+            update_rates();
+        }
+    }
+
+    // save module state
+    json_t *dataToJson(void) override {
+        json_t *root = json_object();
+        jsonHelperSaveInt(root, "sleep_floor", sleep_floor);
+        jsonHelperSaveInt(root, "mem16", mem16);
+        jsonHelperSaveInt(root, "del_long", del_long);
+        jsonHelperSaveInt(root, "echo_taps", echo_taps);
+        jsonHelperSaveInt(root, "int_rate", int_rate);
+        jsonHelperSaveInt(root, "stereo", stereo);
+        jsonHelperSaveInt(root, "fdn_rev", fdn_rev);
+        jsonHelperSaveInt(root, "offload", offload);
+        return root;
+    }
+
+    // load module state
+    void dataFromJson(json_t *root) override {
+        int temp;
+        if(jsonHelperLoadInt(root, "sleep_floor", &temp) == 0) {
+            sleep_floor = DSP_UTILS_CLAMP_RANGE(temp, 0, SLEEP_FLOOR_NUM - 1);
+        }
+        if(jsonHelperLoadInt(root, "mem16", &temp) == 0) {
+            mem16 = (temp != 0);
+        }
+        if(jsonHelperLoadInt(root, "del_long", &temp) == 0) {
+            del_long = DSP_UTILS_CLAMP_RANGE(temp, 0, DEL_LONG_NUM - 1);
+        }
+        if(jsonHelperLoadInt(root, "echo_taps", &temp) == 0) {
+            echo_taps = DSP_UTILS_CLAMP_RANGE(temp, 0, ECHO_TAPS_NUM - 1);
+        }
+        if(jsonHelperLoadInt(root, "int_rate", &temp) == 0) {
+            int_rate = (temp != 0);
+        }
+        if(jsonHelperLoadInt(root, "stereo", &temp) == 0) {
+            stereo = (temp != 0);
+        }
+        if(jsonHelperLoadInt(root, "fdn_rev", &temp) == 0) {
+            fdn_rev = (temp != 0);
+        }
+        if(jsonHelperLoadInt(root, "offload", &temp) == 0) {
+            offload_set(temp != 0);
+        }
     }
 
     // set params based on input
     void setParams(void) {
-        float fscale = AUDIO_FS / (float)32768.0;  // scale for orig samplerate
-        int new_rev;
+        float fscale;
+        int new_rev, temp;
+        if(int_rate != int_rate_cur || stereo != stereo_cur ||
+                del_long != del_long_cur || poly_calc_groups() != poly_groups) {
+            update_rates();
+        }
+        if(fdn_rev != fdn_rev_cur) {
+            fdn_rev_cur = fdn_rev;
+            rev = -1;  // reset the tank state
+        }
+        fscale = REV_FS / (float)REV_DESIGN_FS;  // scale for orig samplerate
+        // storage type changed - keep running on the old memory until
+        // the new memory is ready
+        if(mem16 != dmem_req_mem16) {
+            dmem_request();
+        }
+        dmem_update();
         if(params[REV_SW].getValue() > 0.5) {
             new_rev = 1;
         }
@@ -283,8 +1326,12 @@ struct V103_Reverb_Delay : Module {
                     set_coeff(REV_COEFF_DEL2, (int)(2250.0 * fscale));
                     set_coeff(REV_COEFF_LPF_CUTOFF, 200.0);
                     set_coeff(REV_COEFF_HPF_CUTOFF, 4000.0);
-                    del_len = (int)(AUDIO_FS * 0.5);
+                    del_len = (int)(AUDIO_FS * echo_time);
                     set_coeff(REV_COEFF_ECHO, del_len);
+                    set_coeff(REV_COEFF_FDN1, (int)(1693.0 * fscale));
+                    set_coeff(REV_COEFF_FDN2, (int)(2053.0 * fscale));
+                    set_coeff(REV_COEFF_FDN3, (int)(2399.0 * fscale));
+                    set_coeff(REV_COEFF_FDN4, (int)(2803.0 * fscale));
                     calc_coeffs();
                     break;
                 case 0:
@@ -299,8 +1346,12 @@ struct V103_Reverb_Delay : Module {
                     set_coeff(REV_COEFF_DEL2, (int)(1550.0 * fscale));
                     set_coeff(REV_COEFF_LPF_CUTOFF, 400.0);
                     set_coeff(REV_COEFF_HPF_CUTOFF, 2000.0);
-                    del_len = (int)(AUDIO_FS * 0.5);
+                    del_len = (int)(AUDIO_FS * echo_time);
                     set_coeff(REV_COEFF_ECHO, del_len);
+                    set_coeff(REV_COEFF_FDN1, (int)(877.0 * fscale));
+                    set_coeff(REV_COEFF_FDN2, (int)(1063.0 * fscale));
+                    set_coeff(REV_COEFF_FDN3, (int)(1237.0 * fscale));
+                    set_coeff(REV_COEFF_FDN4, (int)(1429.0 * fscale));
                     calc_coeffs();
                     break;
             }
@@ -312,8 +1363,32 @@ struct V103_Reverb_Delay : Module {
         filter = 0.7;
         size = 0.7;
         krt = (size * 0.25) + 0.6;
+        // each FDN line decays at about the same rate as the figure-eight
+        // tank - the allpasses in the tank loop stretch it so the tank
+        // loses 2 x krt over about 1.7 x its loop length
+        for(temp = 0; temp < FDN_LINES; temp ++) {
+            fdn_gain[temp] = powf(krt, 1.2f * fdn_len[temp] / (float)rev_loop);
+        }
 
         del_mix = params[POT_DEL_MIX].getValue();
+        echo_set_taps();
+
+        switch(sleep_floor) {
+            case SLEEP_FLOOR_96DB:
+                sleep_level = SLEEP_REF_LEVEL * powf(10.0, -96.0 / 20.0);
+                break;
+            case SLEEP_FLOOR_120DB:
+                sleep_level = SLEEP_REF_LEVEL * powf(10.0, -120.0 / 20.0);
+                break;
+            case SLEEP_FLOOR_144DB:
+                sleep_level = SLEEP_REF_LEVEL * powf(10.0, -144.0 / 20.0);
+                break;
+            case SLEEP_FLOOR_OFF:
+            default:
+                sleep_level = 0.0;
+                sleeping = 0;
+                break;
+        }
 
         if(peak > 5.0) {
             lights[CLIP_LED].setBrightness(1.0);
@@ -324,6 +1399,382 @@ struct V103_Reverb_Delay : Module {
         }
     }
 
+    // round a delay memory length up to a power of 2
+    int pow2_len(int len) {
+        int temp = 1;
+        while(temp < len) {
+            temp = temp << 1;
+        }
+        return temp;
+    }
+
+    // get the tank memory length needed for the largest reverb layout
+    int dmem_calc_len(int fs) {
+        float fscale = fs / (float)REV_DESIGN_FS;
+        // tank lines plus 1 sample between each
+        if(stereo_cur && poly_groups == 0) {
+            // left tank then the longer right tank
+            return pow2_len((int)(REV_TANK_LEN_MAX * fscale) * 2 +
+                (int)(REV_STEREO_SPREAD * fscale) * REV_TANK_LINES + REV_TANK_LINES * 2);
+        }
+        return pow2_len((int)(REV_TANK_LEN_MAX * fscale) + REV_TANK_LINES);
+    }
+
+    // get the echo memory length needed at a samplerate
+    int emem_calc_len(int fs) {
+        // echo line plus the interpolated sample
+        return pow2_len((int)(fs * echo_time) + 2);
+    }
+
+    // get the echo storage type - long delays are always 16 bit
+    int emem_calc_mem16(void) {
+        if(poly_groups) {
+            return 0;
+        }
+        return mem16 || echo_time > ECHO_TIME;
+    }
+
+    // request new delay memory for the current samplerate and storage type
+    // polyphonic memory is always float
+    void dmem_request(void) {
+        dmem_alloc.request(dmem_need, emem_need, poly_groups ? 0 : mem16,
+            emem_calc_mem16(), poly_groups);
+        dmem_req_mem16 = mem16;
+    }
+
+    // use a new delay memory block
+    void dmem_install(V103_DelayBlock *block) {
+        dmem_block = block;
+        dmem_mem16 = block->mem16;
+        dmem_emem16 = block->emem16;
+        dmem_groups = block->groups;
+        dlen = block->dlen;
+        elen = block->elen;
+        if(dmem_mem16) {
+            tank16.setBuffer((int16_t *)block->dmem, dlen);
+            dmem = NULL;
+        }
+        else {
+            dmem = (float *)block->dmem;
+        }
+        if(dmem_emem16) {
+            echo16.setBuffer((int16_t *)block->emem, elen);
+            emem = NULL;
+        }
+        else {
+            emem = (float *)block->emem;
+        }
+        dp = 0;
+        ep = 0;
+        dmem_used = 0;
+        dmem_wait = 0;
+        poly_reset();
+    }
+
+    // clear the polyphonic voice state
+    void poly_reset(void) {
+        int g;
+        for(g = 0; g < POLY_GROUPS_MAX; g ++) {
+            poly_lfilt_z1[g] = 0.0f;
+            poly_hfilt_z1[g] = 0.0f;
+            poly_feedback[g] = 0.0f;
+            poly_del_lp_z1[g] = 0.0f;
+        }
+    }
+
+    // swap in newly allocated delay memory if the allocator has some ready
+    void dmem_update(void) {
+        V103_DelayBlock *block = dmem_alloc.take();
+        if(block == NULL) {
+            return;
+        }
+        // samplerate changed again while this was being allocated
+        if(block->dlen != dmem_need || block->elen != emem_need ||
+                block->groups != poly_groups ||
+                block->mem16 != (poly_groups ? 0 : mem16) ||
+                block->emem16 != emem_calc_mem16()) {
+            dmem_alloc.retire(block);
+            return;
+        }
+        dmem_alloc.retire(dmem_block);
+        dmem_install(block);
+    }
+
+    // get the whole address and fraction of an echo tap
+    // the tap delay is worked out in double so long delays keep the fraction
+    // tap - the tap number
+    // addr - the whole address returned
+    // returns the fraction
+    float echo_tap_addr(int tap, int *addr) {
+        double delay = (double)del_len * del_time * tap_time[tap];
+        *addr = (int)delay;
+        return (float)(delay - *addr);
+    }
+
+    // read all of the echo taps four at a time
+    // mem / p / len - the echo memory, pointer and length
+    // scale - the full scale of the memory in volts
+    // outl / outr - the mixed taps
+    // fb - the feedback mix of the taps
+    template <typename T>
+    void echo_taps_process(T *mem, int p, int len, float scale,
+            float *outl, float *outr, float *fb) {
+        simd::float_4 tap, next, fract, suml, sumr, sumfb;
+        int g, i, addr;
+        suml = 0.0f;
+        sumr = 0.0f;
+        sumfb = 0.0f;
+        for(g = 0; g < tap_num / 4; g ++) {
+            for(i = 0; i < 4; i ++) {
+                fract[i] = echo_tap_addr((g * 4) + i, &addr);
+                addr += p + echo_in;
+                tap[i] = v103_mem_read(mem, addr & (len - 1));
+                next[i] = v103_mem_read(mem, (addr + 1) & (len - 1));
+            }
+            tap += (next - tap) * fract;
+            suml += tap * tap_gl[g];
+            sumr += tap * tap_gr[g];
+            sumfb += tap * tap_fb[g];
+        }
+        *outl = v103_hsum(suml) * scale;
+        *outr = v103_hsum(sumr) * scale;
+        *fb = v103_hsum(sumfb) * scale;
+    }
+
+    // set up the echo taps for the pattern and the panel settings
+    void echo_set_taps(void) {
+        int i;
+        switch(echo_taps) {
+            case ECHO_TAPS_SPREAD:
+                // 16 taps fanning out from the center and fading away
+                tap_num = 16;
+                for(i = 0; i < tap_num; i ++) {
+                    tap_time[i] = (i + 1) / 16.0f;
+                    tap_gain[i] = 0.5f * (1.0f - (i / 20.0f));
+                    tap_pan[i] = ((i & 0x01) ? 1.0f : -1.0f) * (i / 15.0f);
+                    tap_send[i] = 0.0f;
+                }
+                tap_send[15] = 0.4f;
+                break;
+            case ECHO_TAPS_PINGPONG:
+                // 8 taps bouncing from side to side
+                tap_num = 8;
+                for(i = 0; i < tap_num; i ++) {
+                    tap_time[i] = (i + 1) / 8.0f;
+                    tap_gain[i] = powf(0.8f, i);
+                    tap_pan[i] = (i & 0x01) ? 1.0f : -1.0f;
+                    tap_send[i] = 0.0f;
+                }
+                tap_send[7] = 0.4f;
+                break;
+            case ECHO_TAPS_PANEL:
+            default:
+                // main tap plus the syncopated taps on each side
+                tap_num = 4;
+                tap_time[0] = 1.0f;
+                tap_gain[0] = 1.0f;
+                tap_pan[0] = 0.0f;
+                tap_send[0] = 0.0f;
+                tap_time[1] = del_synco_t1;
+                tap_gain[1] = del_synco;
+                tap_pan[1] = -1.0f;
+                tap_send[1] = 0.0f;
+                tap_time[2] = del_synco_t2;
+                tap_gain[2] = del_synco;
+                tap_pan[2] = 1.0f;
+                tap_send[2] = 0.4f;
+                tap_time[3] = 0.0f;
+                tap_gain[3] = 0.0f;
+                tap_pan[3] = 0.0f;
+                tap_send[3] = 0.0f;
+                break;
+        }
+        for(i = 0; i < tap_num; i ++) {
+            tap_gl[i / 4][i % 4] = del_mix * tap_gain[i] * DSP_UTILS_MIN(1.0f, 1.0f - tap_pan[i]);
+            tap_gr[i / 4][i % 4] = del_mix * tap_gain[i] * DSP_UTILS_MIN(1.0f, 1.0f + tap_pan[i]);
+            tap_fb[i / 4][i % 4] = tap_send[i];
+        }
+    }
+
+    // run the selected mono reverb tank on the installed memory
+    // acc - the filtered input
+    // outl / outr - the tank outputs
+    void mono_tank_process(float acc, float *outl, float *outr) {
+        if(fdn_rev_cur) {
+            if(dmem_mem16) {
+                fdn_process(tank16.delay, &tank16.dp, tank16.dlen,
+                    (float)MEM16_RANGE, acc, outl, outr);
+            }
+            else {
+                fdn_process(dmem, &dp, dlen, 1.0f, acc, outl, outr);
+            }
+        }
+        else if(dmem_mem16) {
+            tank16_process(acc, outl, outr);
+        }
+        else {
+            DSP_UTILS_DROT(dp, dlen);
+            tank_process(dmem, acc, outl, outr);
+        }
+    }
+
+    // mix the FDN lines with a 4x4 hadamard matrix scaled to be orthonormal
+    simd::float_4 fdn_hadamard(simd::float_4 x) {
+        simd::float_4 temp;
+        temp = simd::float_4(x[1], x[0], x[3], x[2]);
+        x = (x * simd::float_4(1.0f, -1.0f, 1.0f, -1.0f)) + temp;
+        temp = simd::float_4(x[2], x[3], x[0], x[1]);
+        x = (x * simd::float_4(1.0f, 1.0f, -1.0f, -1.0f)) + temp;
+        return x * 0.5f;
+    }
+
+    // run the FDN reverb - the input allpasses diffuse the input and
+    // then it feeds 4 delay lines mixed together in one float_4
+    // mem / p / len - the tank memory, pointer and length
+    // scale - the full scale of the memory in volts
+    // acc - the filtered input
+    // outl / outr - the tank outputs
+    template <typename T>
+    void fdn_process(T *mem, int *p, int len, float scale, float acc,
+            float *outl, float *outr) {
+        simd::float_4 lines;
+        float temp1;
+        int i, k;
+        *p = (*p - 1) & (len - 1);
+        acc *= 1.0f / scale;
+        // input allpasses - lane 0 of the stereo layout is the mono layout
+        for(k = 0; k < 4; k ++) {
+            temp1 = v103_mem_read(mem, (*p + st_api[k][0]) & (len - 1));
+            acc += temp1 * -kap;
+            v103_mem_write(mem, (*p + st_api_in[k][0]) & (len - 1), acc);
+            acc = (acc * kap) + temp1;
+        }
+
+        // line outputs
+        for(i = 0; i < FDN_LINES; i ++) {
+            lines[i] = v103_mem_read(mem, (*p + fdn[i]) & (len - 1));
+        }
+        // each output is the sum of 2 lines so -3dB to match the tank
+        *outl = (lines[0] - lines[2]) * (scale * 0.7071f);
+        *outr = (lines[1] - lines[3]) * (scale * 0.7071f);
+
+        // damping, mixing and decay
+        DSP_UTILS_F1LP(lines, lines, fdn_damp, fdn_z1);
+        lines = (fdn_hadamard(lines) * fdn_gain) + acc;
+        for(i = 0; i < FDN_LINES; i ++) {
+            v103_mem_write(mem, (*p + fdn_in[i]) & (len - 1), lines[i]);
+        }
+    }
+
+    // run the reverb tank - the memory must be rotated first
+    // mem - the tank memory - float or float_4 for 4 interleaved voices
+    // acc - the filtered input
+    // outl / outr - the tank outputs
+    template <typename T>
+    void tank_process(T *mem, T acc, T *outl, T *outr) {
+        T apout, temp1, it1;
+        DSP_UTILS_AP(mem, dp, dlen, api1_in, api1, kap);
+        DSP_UTILS_AP(mem, dp, dlen, api2_in, api2, kap);
+        DSP_UTILS_AP(mem, dp, dlen, api3_in, api3, kap);
+        DSP_UTILS_AP(mem, dp, dlen, api4_in, api4, kap);
+        apout = acc;
+
+        DSP_UTILS_DREAD(mem, dp, dlen, del2, temp1);
+        acc += temp1;
+        acc *= krt;
+        DSP_UTILS_AP(mem, dp, dlen, ap1_in, ap1, kap);
+        DSP_UTILS_DWRITE(mem, dp, dlen, del1_in, acc);
+        *outl = acc;
+
+        acc = apout;
+        DSP_UTILS_DREAD(mem, dp, dlen, del1, temp1);
+        acc += temp1;
+        acc *= krt;
+        DSP_UTILS_AP(mem, dp, dlen, ap2_in, ap2, kap);
+        DSP_UTILS_DWRITE(mem, dp, dlen, del2_in, acc);
+        *outr = acc;
+    }
+
+    // run the reverb tank in 16 bit memory
+    // the memory holds +/-1.0 so the tank runs scaled down by MEM16_RANGE
+    // acc - the filtered input
+    // outl / outr - the tank outputs
+    void tank16_process(float acc, float *outl, float *outr) {
+        float apout, temp1;
+        tank16.rotate();
+        acc *= (float)(1.0 / MEM16_RANGE);
+        tank16.allpass(api1_in, api1, kap, &acc);
+        tank16.allpass(api2_in, api2, kap, &acc);
+        tank16.allpass(api3_in, api3, kap, &acc);
+        tank16.allpass(api4_in, api4, kap, &acc);
+        apout = acc;
+
+        temp1 = tank16.read(del2);
+        acc += temp1;
+        acc *= krt;
+        tank16.allpass(ap1_in, ap1, kap, &acc);
+        tank16.write(del1_in, acc);
+        *outl = acc * (float)MEM16_RANGE;
+
+        acc = apout;
+        temp1 = tank16.read(del1);
+        acc += temp1;
+        acc *= krt;
+        tank16.allpass(ap2_in, ap2, kap, &acc);
+        tank16.write(del2_in, acc);
+        *outr = acc * (float)MEM16_RANGE;
+    }
+
+    // run both reverb tanks together in SIMD lanes
+    // the right tank lines are longer than the left so each lane
+    // gathers from its own address
+    // mem / p / len - the tank memory, pointer and length
+    // scale - the full scale of the memory in volts
+    // acc - the filtered input for each lane
+    // outl / outr - the tank outputs
+    template <typename T>
+    void tank_stereo_process(T *mem, int *p, int len, float scale,
+            simd::float_4 acc, float *outl, float *outr) {
+        simd::float_4 apout, temp1;
+        float accl, accr, templ, tempr;
+        int i, k;
+        *p = (*p - 1) & (len - 1);
+        // input allpasses - both halves of a tank see the same chain so
+        // only the left and right chains are run
+        accl = acc[0] * (1.0f / scale);
+        accr = acc[2] * (1.0f / scale);
+        for(k = 0; k < 4; k ++) {
+            templ = v103_mem_read(mem, (*p + st_api[k][0]) & (len - 1));
+            tempr = v103_mem_read(mem, (*p + st_api[k][1]) & (len - 1));
+            accl += templ * -kap;
+            accr += tempr * -kap;
+            v103_mem_write(mem, (*p + st_api_in[k][0]) & (len - 1), accl);
+            v103_mem_write(mem, (*p + st_api_in[k][1]) & (len - 1), accr);
+            accl = (accl * kap) + templ;
+            accr = (accr * kap) + tempr;
+        }
+        apout = simd::float_4(accl, accl, accr, accr);
+
+        // tank halves
+        for(i = 0; i < 4; i ++) {
+            temp1[i] = v103_mem_read(mem, (*p + st_xread[i]) & (len - 1));
+        }
+        acc = (apout + temp1) * krt;
+        for(i = 0; i < 4; i ++) {
+            temp1[i] = v103_mem_read(mem, (*p + st_ap[i]) & (len - 1));
+        }
+        acc += temp1 * -kap;
+        for(i = 0; i < 4; i ++) {
+            v103_mem_write(mem, (*p + st_ap_in[i]) & (len - 1), acc[i]);
+        }
+        acc = (acc * kap) + temp1;
+        for(i = 0; i < 4; i ++) {
+            v103_mem_write(mem, (*p + st_del_in[i]) & (len - 1), acc[i]);
+        }
+        *outl = acc[0] * scale;
+        *outr = acc[3] * scale;
+    }
+
     int set_coeff(int coeff, float val) {
         int temp;
         switch(coeff) {
@@ -396,6 +1847,16 @@ struct V103_Reverb_Delay : Module {
                 }
                 echo = temp;
                 break;
+            case REV_COEFF_FDN1:
+            case REV_COEFF_FDN2:
+            case REV_COEFF_FDN3:
+            case REV_COEFF_FDN4:
+                temp = (int)roundf(val);
+                if(temp < 1) {
+                    return -1;
+                }
+                fdn[coeff - REV_COEFF_FDN1] = temp;
+                break;
             default:
                 return -1;
         }
@@ -404,8 +1865,10 @@ struct V103_Reverb_Delay : Module {
 
     // calculates internal coeffs once values are set
     void calc_coeffs(void) {
-        int temp;
+        int temp, i, spread;
         float tempf1;
+        int l_in[REV_TANK_LINES], l_out[REV_TANK_LINES];
+        int r_in[REV_TANK_LINES], r_out[REV_TANK_LINES];
         // delay lines
         temp = 0;
         api1_in = temp;
@@ -439,10 +1902,58 @@ struct V103_Reverb_Delay : Module {
         del2_in = temp;
         temp += del2;
         del2 = temp;
-        temp ++;
-        echo_in = temp;
-        temp += echo;
-        echo = temp;
+        rev_loop = del2 - ap1_in;
+        // FDN layout - the lines replace the figure-eight tank
+        temp = api4 + 1;
+        for(i = 0; i < FDN_LINES; i ++) {
+            fdn_len[i] = fdn[i];
+            fdn_in[i] = temp;
+            temp += fdn[i];
+            fdn[i] = temp;
+            temp ++;
+        }
+        // stereo layout - the right tank follows the left tank with
+        // each line made a little longer to decorrelate the tails
+        l_in[0] = api1_in; l_out[0] = api1;
+        l_in[1] = api2_in; l_out[1] = api2;
+        l_in[2] = api3_in; l_out[2] = api3;
+        l_in[3] = api4_in; l_out[3] = api4;
+        l_in[4] = ap1_in; l_out[4] = ap1;
+        l_in[5] = del1_in; l_out[5] = del1;
+        l_in[6] = ap2_in; l_out[6] = ap2;
+        l_in[7] = del2_in; l_out[7] = del2;
+        spread = (int)(REV_STEREO_SPREAD * (REV_FS / (float)REV_DESIGN_FS));
+        temp = del2 + 1;
+        for(i = 0; i < REV_TANK_LINES; i ++) {
+            r_in[i] = temp;
+            temp += l_out[i] - l_in[i] + spread;
+            r_out[i] = temp;
+            temp ++;
+        }
+        st_end = r_out[REV_TANK_LINES - 1];
+        for(i = 0; i < 4; i ++) {
+            st_api_in[i][0] = l_in[i];
+            st_api_in[i][1] = r_in[i];
+            st_api[i][0] = l_out[i];
+            st_api[i][1] = r_out[i];
+        }
+        // lanes are L ap1/del1, L ap2/del2, R ap1/del1, R ap2/del2
+        st_xread[0] = del2; st_xread[1] = del1;
+        st_xread[2] = r_out[7]; st_xread[3] = r_out[5];
+        st_ap_in[0] = ap1_in; st_ap_in[1] = ap2_in;
+        st_ap_in[2] = r_in[4]; st_ap_in[3] = r_in[6];
+        st_ap[0] = ap1; st_ap[1] = ap2;
+        st_ap[2] = r_out[4]; st_ap[3] = r_out[6];
+        st_del_in[0] = del1_in; st_del_in[1] = del2_in;
+        st_del_in[2] = r_in[5]; st_del_in[3] = r_in[7];
+        // echo line has its own ring
+        echo_in = 0;
+        echo = echo_in + echo;
+        // every tank and echo address must be rewritten before sleeping
+        // and the resampler histories must be flushed
+        temp = (stereo_cur && poly_groups == 0) ? st_end : del2;
+        sleep_len = DSP_UTILS_MAX((temp + 1 + dsp2::PolyphaseDecimator::TAPS_PER_PHASE * 2) * rate_div,
+            echo + 2);
         // filters
         tempf1 = lfilt_a0;
         DSP_UTILS_F1SC(tempf1, lfilt_a0);
@@ -450,6 +1961,14 @@ struct V103_Reverb_Delay : Module {
         DSP_UTILS_F1SC(tempf1, hfilt_a0);
         lfilt_z1 = 0.0;
         lfilt_z1 = 0.0;
+        st_lfilt_z1 = 0.0f;
+        st_hfilt_z1 = 0.0f;
+        fdn_z1 = 0.0f;
+        fdn_damp = 1.0 - expf(-2.0 * M_PI * (FDN_DAMP_FREQ / (float)REV_FS));
+        for(i = 0; i < POLY_GROUPS_MAX; i ++) {
+            poly_lfilt_z1[i] = 0.0f;
+            poly_hfilt_z1[i] = 0.0f;
+        }
     }
 };
 
@@ -478,6 +1997,29 @@ struct V103_Reverb_DelayWidget : ModuleWidget {
         addChild(createParamCentered<KilpatrickToggle3P>(mm2px(Vec(19.982, 99.798)), module, V103_Reverb_Delay::DEL_SW));
         addChild(createParamCentered<KilpatrickToggle2P>(mm2px(Vec(32.682, 99.798)), module, V103_Reverb_Delay::REV_SW));
     }
+
+    void appendContextMenu(Menu *menu) override {
+        V103_Reverb_Delay *module = dynamic_cast<V103_Reverb_Delay*>(this->module);
+        if(module == NULL) {
+            return;
+        }
+        menuHelperAddSpacer(menu);
+        menu->addChild(createIndexPtrSubmenuItem("Sleep Floor",
+            {"Off", "-96dB", "-120dB", "-144dB"}, &module->sleep_floor));
+        menu->addChild(createBoolPtrMenuItem("16 Bit Delay Memory", "", &module->mem16));
+        menu->addChild(createIndexPtrSubmenuItem("Echo Taps",
+            {"Panel", "16 Tap Spread", "8 Tap Ping-Pong"}, &module->echo_taps));
+        menu->addChild(createIndexPtrSubmenuItem("Long Delay",
+            {"Off", "5s", "30s", "120s"}, &module->del_long));
+        menu->addChild(createBoolPtrMenuItem("Reverb at Internal Rate", "", &module->int_rate));
+        menu->addChild(createBoolPtrMenuItem("True Stereo Reverb", "", &module->stereo));
+        menu->addChild(createBoolPtrMenuItem("FDN Reverb", "", &module->fdn_rev));
+        menu->addChild(createBoolMenuItem("Offload to Worker Thread",
+            module->offload_inline ? "missed deadline - inline" :
+            string::f("+%d samples", OFFLOAD_LATENCY),
+            [=]() { return module->offload != 0; },
+            [=](bool val) { module->offload_set(val); }));
+    }
 };
 
 Model* modelV103_Reverb_Delay = createModel<V103_Reverb_Delay, V103_Reverb_DelayWidget>("V103-Reverb_Delay");
@@ -28,6 +28,8 @@
 
 #define DSP_UTILS_MAX(x, y) ((x)>(y) ? (x) : (y))
 
+#define DSP_UTILS_MIN(x, y) ((x)<(y) ? (x) : (y))
+
 #define DSP_UTILS_CLAMP(x) (((x) > (1.0)) ? (1.0) : \
     (((x) < (-1.0)) ? (-1.0) : (x)))
 
@@ -8,6 +8,11 @@
  *
  */
 #include "DspUtils2.h"
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 using namespace dsp2;
 
@@ -32,6 +37,23 @@ float LevelSense::process(float in) {
     return z1 = ((in - z1) * a0Release) + z1;
 }
 
+// run 1-pole lowpass on a block
+// the state is kept in a local for the whole block
+void LevelSense::processBlock(const float *in, float *out, int len) {
+    float z = z1;
+    int i;
+    for(i = 0; i < len; i ++) {
+        if(in[i] > z) {
+            z = ((in[i] - z) * a0Attack) + z;
+        }
+        else {
+            z = ((in[i] - z) * a0Release) + z;
+        }
+        out[i] = z;
+    }
+    z1 = z;
+}
+
 //
 // Filter1Pole
 //
@@ -51,6 +73,32 @@ float Filter1Pole::highpass(float in) {
     return in - z1;
 }
 
+// run 1-pole lowpass on a block
+// the state is kept in a local for the whole block
+void Filter1Pole::lowpassBlock(const float *in, float *out, int len) {
+    float z = z1;
+    int i;
+    for(i = 0; i < len; i ++) {
+        z = ((in[i] - z) * a0) + z;
+        out[i] = z;
+    }
+    z1 = z;
+}
+
+// run 1-pole highpass on a block
+// the state is kept in a local for the whole block
+void Filter1Pole::highpassBlock(const float *in, float *out, int len) {
+    float z = z1;
+    float val;
+    int i;
+    for(i = 0; i < len; i ++) {
+        val = in[i];
+        z = ((val - z) * a0) + z;
+        out[i] = val - z;
+    }
+    z1 = z;
+}
+
 // get the most recently computied out
 float Filter1Pole::getOutput(void) {
     return z1;
@@ -66,13 +114,65 @@ float Filter1Pole::getOutput(void) {
 // gain: gain factor
 // fs: audio samplerate in Hz
 void Filter2Pole::setCutoff(int type, float freq, float q, float gain, float fs) {
-    float norm;
-//        float V = pow(10, fabs(gain) / 20.0);
-    float V = gain;
-    float K = tan(M_PI * freq / fs);
     this->freq = freq;
     this->gain = gain;
     this->q = q;
+    setCoeffs(type, tan(M_PI * freq / fs), q, gain);
+    z1 = 0.0f;
+    z2 = 0.0f;
+}
+
+// set the filter cutoff for modulation - the state is kept
+// type: filter type
+// freq: frequency in Hz - range: 0.0f to 0.499f * fs
+// q: Q factor
+// gain: gain factor
+// fs: audio samplerate in Hz
+void Filter2Pole::setCutoffFast(int type, float freq, float q, float gain, float fs) {
+    this->freq = freq;
+    this->gain = gain;
+    this->q = q;
+    setCoeffs(type, fastTanPi(freq / fs), q, gain);
+    rampCount = 0;
+}
+
+// ramp the filter cutoff for modulation - the state is kept
+// type: filter type
+// freq: frequency in Hz - range: 0.0f to 0.499f * fs
+// q: Q factor
+// gain: gain factor
+// fs: audio samplerate in Hz
+// samples: the number of calls to processRamp() to reach the new coeffs
+void Filter2Pole::setCutoffRamp(int type, float freq, float q, float gain,
+        float fs, int samples) {
+    Filter2Pole target;
+    float scale;
+    if(samples < 1) {
+        setCutoffFast(type, freq, q, gain, fs);
+        return;
+    }
+    this->freq = freq;
+    this->gain = gain;
+    this->q = q;
+    target.setCoeffs(type, fastTanPi(freq / fs), q, gain);
+    scale = 1.0f / (float)samples;
+    da0 = (target.a0 - a0) * scale;
+    da1 = (target.a1 - a1) * scale;
+    da2 = (target.a2 - a2) * scale;
+    db1 = (target.b1 - b1) * scale;
+    db2 = (target.b2 - b2) * scale;
+    rampCount = samples;
+}
+
+// set the coeffs
+// type: filter type
+// K: tan(pi * freq / fs)
+// q: Q factor
+// gain: gain factor
+void Filter2Pole::setCoeffs(int type, float K, float q, float gain) {
+    float norm;
+//        float V = pow(10, fabs(gain) / 20.0);
+    float V = gain;
     switch(type) {
         case TYPE_LPF:
             norm = 1.0 / (1.0 + K / q + K * K);
@@ -161,8 +261,6 @@ void Filter2Pole::setCutoff(int type, float freq, float q, float gain, float fs)
             }
             break;
     }
-    z1 = 0.0f;
-    z2 = 0.0f;
 }
 
 // process a sample
@@ -173,6 +271,37 @@ float Filter2Pole::process(float in) {
     return out;
 }
 
+// process a block
+// the coeffs and state are kept in locals for the whole block
+void Filter2Pole::processBlock(const float *in, float *out, int len) {
+    float c0 = a0, c1 = a1, c2 = a2, d1 = b1, d2 = b2;
+    float s1 = z1, s2 = z2;
+    float val, res;
+    int i;
+    for(i = 0; i < len; i ++) {
+        val = in[i];
+        res = (val * c0) + s1;
+        s1 = (val * c1) + s2 - (res * d1);
+        s2 = (val * c2) - (res * d2);
+        out[i] = res;
+    }
+    z1 = s1;
+    z2 = s2;
+}
+
+// process a sample and step the coeff ramp
+float Filter2Pole::processRamp(float in) {
+    if(rampCount > 0) {
+        a0 += da0;
+        a1 += da1;
+        a2 += da2;
+        b1 += db1;
+        b2 += db2;
+        rampCount --;
+    }
+    return process(in);
+}
+
 // get the frequency as a string
 std::string Filter2Pole::getFreqStr(void) {
     char tempstr[16];
@@ -205,6 +334,112 @@ std::string Filter2Pole::getQStr(void) {
     return tempstr;
 }
 
+//
+// Filter2PoleCascade
+//
+// constructor - all sections pass through
+Filter2PoleCascade::Filter2PoleCascade() {
+    int i;
+    for(i = 0; i < SECTIONS; i ++) {
+        setBypass(i);
+    }
+    reset();
+}
+
+// set one section to a Filter2Pole design and clear its state
+void Filter2PoleCascade::setSection(int section, int type, float freq,
+        float q, float gain, float fs) {
+    Filter2Pole filt;
+    filt.setCutoff(type, freq, q, gain, fs);
+    a0[section] = filt.a0;
+    a1[section] = filt.a1;
+    a2[section] = filt.a2;
+    b1[section] = filt.b1;
+    b2[section] = filt.b2;
+    z1[section] = 0.0f;
+    z2[section] = 0.0f;
+}
+
+// set one section to pass the signal through
+void Filter2PoleCascade::setBypass(int section) {
+    a0[section] = 1.0f;
+    a1[section] = 0.0f;
+    a2[section] = 0.0f;
+    b1[section] = 0.0f;
+    b2[section] = 0.0f;
+    z1[section] = 0.0f;
+    z2[section] = 0.0f;
+}
+
+// set a Butterworth filter
+// returns -1 on error, 0 on success
+int Filter2PoleCascade::setButterworth(int type, int order, float freq, float fs) {
+    int i;
+    if(order < 2 || order > SECTIONS * 2 || (order & 1)) {
+        return -1;
+    }
+    // each pole pair k has Q = 1 / (2 sin((2k - 1) pi / 2N))
+    for(i = 0; i < SECTIONS; i ++) {
+        if(i < order / 2) {
+            setSection(i, type, freq,
+                0.5f / sinf((float)(2 * i + 1) * (float)M_PI / (float)(2 * order)),
+                1.0f, fs);
+        }
+        else {
+            setBypass(i);
+        }
+    }
+    reset();
+    return 0;
+}
+
+// set a Linkwitz-Riley filter - two Butterworth filters in series
+// returns -1 on error, 0 on success
+int Filter2PoleCascade::setLinkwitzRiley(int type, int order, float freq, float fs) {
+    int i, half;
+    if(order != 4 && order != 8) {
+        return -1;
+    }
+    setButterworth(type, order / 2, freq, fs);
+    // repeat the Butterworth sections in the next lanes
+    half = order / 4;
+    for(i = 0; i < half; i ++) {
+        a0[i + half] = a0[i];
+        a1[i + half] = a1[i];
+        a2[i + half] = a2[i];
+        b1[i + half] = b1[i];
+        b2[i + half] = b2[i];
+    }
+    reset();
+    return 0;
+}
+
+// clear the state
+void Filter2PoleCascade::reset(void) {
+    z1 = Float4Vec{};
+    z2 = Float4Vec{};
+    x = Float4Vec{};
+}
+
+// process a block - the output is delayed by LATENCY samples
+// the coeffs and state are kept in locals for the whole block
+void Filter2PoleCascade::processBlock(const float *in, float *out, int len) {
+    Float4Vec c0 = a0, c1 = a1, c2 = a2, d1 = b1, d2 = b2;
+    Float4Vec s1 = z1, s2 = z2, val = x, res;
+    int i;
+    for(i = 0; i < len; i ++) {
+        val[0] = in[i];
+        res = (val * c0) + s1;
+        s1 = (val * c1) + s2 - (res * d1);
+        s2 = (val * c2) - (res * d2);
+        val = Float4Vec{0.0f, res[0], res[1], res[2]};
+        out[i] = res[3];
+    }
+    z1 = s1;
+    z2 = s2;
+    x = val;
+}
+
 //
 // Levelmeter
 //
@@ -360,37 +595,168 @@ float SimpleLFO::getPhaseShiftedOutput(float phase) {
     return out;
 }
 
+//
+// DelayMem
+//
+// rotate the memory by a block of samples
+void DelayMem::rotateBlock(int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        rotate();
+    }
+}
+
+// read a block of samples no interpolation
+void DelayMem::readBlock(int addr, float *out, int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        out[i] = read(addr - i);
+    }
+}
+
+// read a block of samples interpolated
+void DelayMem::readFractBlock(int addr, float fract, float *out, int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        out[i] = readFract(addr - i, fract);
+    }
+}
+
+// read a block of samples from several interpolated taps and mix them
+void DelayMem::readTaps(const float *addr, const float *gain, int taps,
+        float *out, int len) {
+    int i, j;
+    for(i = 0; i < len; i ++) {
+        out[i] = 0.0f;
+        for(j = 0; j < taps; j ++) {
+            out[i] += readFract((int)addr[j] - i, addr[j] - (int)addr[j]) * gain[j];
+        }
+    }
+}
+
+// write a block of samples
+void DelayMem::writeBlock(int addr, const float *in, int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        write(addr - i, in[i]);
+    }
+}
+
+// run an allpass over a block of samples
+void DelayMem::allpassBlock(int inaddr, int outaddr, float feedback,
+        float *inout, int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        allpass(inaddr - i, outaddr - i, feedback, &inout[i]);
+    }
+}
+
 //
 // DelayMemFloat
 //
+// map a buffer twice back to back - returns NULL on error
+// len - the length in samples - must be a multiple of the page size
+static float *delayMemMapMirror(int len) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    size_t size = sizeof(float) * len;
+    char *base;
+    int fd = syscall(SYS_memfd_create, "dsp2_delay", 0);
+    if(fd < 0) {
+        return NULL;
+    }
+    if(ftruncate(fd, size) != 0) {
+        close(fd);
+        return NULL;
+    }
+    // reserve both halves and then map the file over each one
+    base = (char *)mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if(mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+            mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, size * 2);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    return (float *)base;
+#else
+    return NULL;
+#endif
+}
+
+// unmap a buffer from delayMemMapMirror()
+static void delayMemUnmapMirror(float *buf, int len) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    munmap(buf, sizeof(float) * len * 2);
+#endif
+}
+
 // constructor - pass a pre-allocated buffer and length
 // the length is the number of samples and must be a power of 2
 DelayMemFloat::DelayMemFloat(float *buf, int len) {
-    delay = buf;
-    dlen = len;
-    dp = 0;
+    setBuffer(buf, len);
     preallocated = 1;
+    mirror = MIRROR_NONE;
 }
 
 // constructor - the min len is rounded up to the next
 // power of 2 and the memory is allocated
 DelayMemFloat::DelayMemFloat(int minLen) {
-    int i;
-    dlen = 1;
-    while(dlen < minLen) {
-        dlen = dlen << 1;
+    int len = 1;
+    while(len < minLen) {
+        len = len << 1;
     }
-    delay = (float *)malloc(sizeof(float) * dlen);
-    for(i = 0; i < dlen; i ++) {
-        delay[i] = 0.0f;
+    setBuffer((float *)malloc(sizeof(float) * len), len);
+    preallocated = 0;
+    mirror = MIRROR_NONE;
+    clear();
+}
+
+// constructor - the min len is rounded up to the next
+// power of 2 and a mirrored buffer is allocated
+DelayMemFloat::DelayMemFloat(int minLen, bool mirrored) {
+    float *buf = NULL;
+    int len = 1;
+    while(len < minLen) {
+        len = len << 1;
     }
-    dp = 0;
     preallocated = 0;
+    mirror = MIRROR_NONE;
+    if(mirrored) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+        // each half must be whole pages
+        while(len * (int)sizeof(float) < sysconf(_SC_PAGESIZE)) {
+            len = len << 1;
+        }
+        buf = delayMemMapMirror(len);
+#endif
+        if(buf != NULL) {
+            mirror = MIRROR_MAPPED;
+        }
+        else {
+            buf = (float *)malloc(sizeof(float) * len * 2);
+            mirror = MIRROR_COPY;
+        }
+    }
+    else {
+        buf = (float *)malloc(sizeof(float) * len);
+    }
+    setBuffer(buf, len);
+    clear();
 }
 
 // destructor
 DelayMemFloat::~DelayMemFloat() {
-    if(preallocated == 0) {
+    if(preallocated) {
+        return;
+    }
+    if(mirror == MIRROR_MAPPED) {
+        delayMemUnmapMirror(delay, dlen);
+    }
+    else {
         free(delay);
     }
 }
@@ -398,36 +764,22 @@ DelayMemFloat::~DelayMemFloat() {
 // clear the memory
 void DelayMemFloat::clear(void) {
     int i;
-    for(i = 0; i < dlen; i ++) {
-        delay[i] = 0.0f;
+    Line::clear();
+    if(mirror == MIRROR_COPY) {
+        for(i = 0; i < dlen; i ++) {
+            delay[dlen + i] = 0.0f;
+        }
     }
 }
 
-// rotate the memory
-void DelayMemFloat::rotate(void) {
-    dp = (dp - 1) & (dlen - 1);
-}
-
-// read a sample by address no interpolation
-// addr: address to read from
-float DelayMemFloat::read(int addr) {
-    return delay[(dp + addr) & (dlen - 1)];
-}
-
-// read a sample by address interpolated
-// addr - the address to read from as a float - real = addr, fract = interp
-float DelayMemFloat::readFract(float addr) {
-    float it1 = addr - (int)addr;
-    float out = delay[(dp + (int)addr) & (dlen - 1)] * (1.0 - it1);
-    out += delay[(dp + ((int)addr + 1)) & (dlen - 1)] * it1;
-    return out;
-}
-
 // write into the delay line
 // addr - the address to write to
 // in - the input var
 void DelayMemFloat::write(int addr, float in) {
-    delay[(dp + addr) & (dlen - 1)] = in;
+    Line::write(addr, in);
+    if(mirror == MIRROR_COPY) {
+        delay[((dp + addr) & (dlen - 1)) + dlen] = in;
+    }
 }
 
 // inaddr - the address to write to
@@ -435,10 +787,11 @@ void DelayMemFloat::write(int addr, float in) {
 // feeback - AP feedback coeff - + = alternating sign, - = same sign
 // inout - used for input and output
 void DelayMemFloat::allpass(int inaddr, int outaddr, float feedback, float *inout) {
-    float it1 = delay[(dp + outaddr) & (dlen - 1)];
-    *inout += it1 * -feedback;
-    delay[(dp + inaddr) & (dlen - 1)] = *inout;
-    *inout = (*inout * feedback) + it1;
+    Line::allpass(inaddr, outaddr, feedback, inout);
+    if(mirror == MIRROR_COPY) {
+        inaddr = (dp + inaddr) & (dlen - 1);
+        delay[inaddr + dlen] = delay[inaddr];
+    }
 }
 
 // inaddr - the address to write to
@@ -446,43 +799,119 @@ void DelayMemFloat::allpass(int inaddr, int outaddr, float feedback, float *inou
 // feedback - AP feedback coeff
 // acc - used for input and output
 void DelayMemFloat::allpassFract(int inaddr, float outaddr, float feedback, float *inout) {
-    float it2 = outaddr - (int)outaddr;
-    float it1 = delay[(dp + (int)outaddr) & (dlen - 1)] * (1.0 - it2);
-    it1 += delay[(dp + ((int)outaddr + 1)) & (dlen - 1)] * it2;
-    *inout += (it1 * -feedback);
-    delay[(dp + inaddr) & (dlen - 1)] = *inout;
-    *inout = (*inout * feedback) + it1;
+    Line::allpassFract(inaddr, outaddr, feedback, inout);
+    if(mirror == MIRROR_COPY) {
+        inaddr = (dp + inaddr) & (dlen - 1);
+        delay[inaddr + dlen] = delay[inaddr];
+    }
+}
+
+// read a block of samples no interpolation
+// a mirrored buffer reads the block in one run
+void DelayMemFloat::readBlock(int addr, float *out, int len) {
+    const float *p;
+    int i;
+    if(mirror == MIRROR_NONE) {
+        Line::readBlock(addr, out, len);
+        return;
+    }
+    p = &delay[((dp + addr) & (dlen - 1)) + dlen];
+    for(i = 0; i < len; i ++) {
+        out[i] = p[-i];
+    }
+}
+
+// read a block of samples interpolated
+// a mirrored buffer reads the block in one run
+void DelayMemFloat::readFractBlock(int addr, float fract, float *out, int len) {
+    const float *p;
+    int i;
+    if(mirror == MIRROR_NONE) {
+        Line::readFractBlock(addr, fract, out, len);
+        return;
+    }
+    p = &delay[((dp + addr + 1) & (dlen - 1)) + dlen];
+    for(i = 0; i < len; i ++) {
+        out[i] = p[-i - 1] * (1.0f - fract) + p[-i] * fract;
+    }
+}
+
+// read a block of samples from several interpolated taps and mix them
+void DelayMemFloat::readTaps(const float *addr, const float *gain, int taps,
+        float *out, int len) {
+    const float *p;
+    float fract, fa, fb;
+    int i, j;
+    if(mirror == MIRROR_NONE) {
+        Line::readTaps(addr, gain, taps, out, len);
+        return;
+    }
+    for(i = 0; i < len; i ++) {
+        out[i] = 0.0f;
+    }
+    for(j = 0; j < taps; j ++) {
+        fract = addr[j] - (int)addr[j];
+        fa = (1.0f - fract) * gain[j];
+        fb = fract * gain[j];
+        p = &delay[((dp + (int)addr[j] + 1) & (dlen - 1)) + dlen];
+        for(i = 0; i < len; i ++) {
+            out[i] += p[-i - 1] * fa + p[-i] * fb;
+        }
+    }
+}
+
+// write a block of samples
+void DelayMemFloat::writeBlock(int addr, const float *in, int len) {
+    Line::writeBlock(addr, in, len);
+    mirrorBlock(addr, len);
+}
+
+// run an allpass over a block of samples
+void DelayMemFloat::allpassBlock(int inaddr, int outaddr, float feedback,
+        float *inout, int len) {
+    Line::allpassBlock(inaddr, outaddr, feedback, inout, len);
+    mirrorBlock(inaddr, len);
+}
+
+// copy a block of the memory into the second half - copy mirror only
+// addr - the address of the first sample
+// len - the number of samples
+void DelayMemFloat::mirrorBlock(int addr, int len) {
+    int i, base;
+    if(mirror != MIRROR_COPY) {
+        return;
+    }
+    for(i = 0; i < len; i ++) {
+        base = (dp + addr - i) & (dlen - 1);
+        delay[base + dlen] = delay[base];
+    }
 }
 
 //
 // DelayMem16
 //
+// constructor - no memory until setBuffer() is called
+DelayMem16::DelayMem16() {
+    preallocated = 1;
+}
+
 // constructor - pass a pre-allocated buffer and length
 // the length is the number of samples and must be a power of 2
 DelayMem16::DelayMem16(int16_t *buf, int len) {
-    int i;
-    delay = buf;
-    dlen = len;
-    for(i = 0; i < dlen; i ++) {
-        delay[i] = 0;
-    }
-    dp = 0;
+    Line::setBuffer(buf, len);
+    Line::clear();
     preallocated = 1;
 }
 
 // constructor - the min len is rounded up to the next
 // power of 2 and the memory is allocated
 DelayMem16::DelayMem16(int minLen) {
-    int i;
-    dlen = 1;
-    while(dlen < minLen) {
-        dlen = dlen << 1;
+    int len = 1;
+    while(len < minLen) {
+        len = len << 1;
     }
-    delay = (int16_t *)malloc(sizeof(int16_t) * dlen);
-    for(i = 0; i < dlen; i ++) {
-        delay[i] = 0;
-    }
-    dp = 0;
+    Line::setBuffer((int16_t *)malloc(sizeof(int16_t) * len), len);
+    Line::clear();
     preallocated = 0;
 }
 
@@ -493,64 +922,45 @@ DelayMem16::~DelayMem16() {
     }
 }
 
-// clear the memory
-void DelayMem16::clear(void) {
-    int i;
-    for(i = 0; i < dlen; i ++) {
-        delay[i] = 0;
+// use a different pre-allocated buffer and length
+// the length is the number of samples and must be a power of 2
+// the buffer is not cleared so it must be cleared already
+void DelayMem16::setBuffer(int16_t *buf, int len) {
+    if(preallocated == 0) {
+        free(delay);
     }
+    Line::setBuffer(buf, len);
+    preallocated = 1;
 }
 
-// rotate the memory
-void DelayMem16::rotate(void) {
-    dp = (dp - 1) & (dlen - 1);
-}
-
-// read a sample by address no interpolation
-// addr: address to read from
-// returns the value in float - range: -1.0f to +1.0f
-float DelayMem16::read(int addr) {
-    return (float)delay[(dp + addr) & (dlen - 1)] * 0.000030518f;
-}
-// read a sample by address interpolated
-// addr - the address to read from as a float - real = addr, fract = interp
-// returns the value in float - range: -1.0f to +1.0f
-float DelayMem16::readFract(float addr) {
-    float it1 = addr - (int)addr;
-    float out = ((float)delay[(dp + (int)addr) & (dlen - 1)] * 0.000030518f) * (1.0 - it1);
-    out += ((float)delay[(dp + ((int)addr + 1)) & (dlen - 1)] * 0.000030518f) * it1;
-    return out;
-}
-
-// write into the delay line
-// addr - the address to write to
-// in - the input var as a float - range: -1.0f to +1.0f
-void DelayMem16::write(int addr, float in) {
-    delay[(dp + addr) & (dlen - 1)] = (int16_t)(in * 32768.0f);
+//
+// DelayMemFloat16
+//
+// constructor - pass a pre-allocated buffer and length
+// the length is the number of samples and must be a power of 2
+DelayMemFloat16::DelayMemFloat16(uint16_t *buf, int len) {
+    Line::setBuffer(buf, len);
+    Line::clear();
+    preallocated = 1;
 }
 
-// inaddr - the address to write to
-// outaddr - the address to read from
-// feeback - AP feedback coeff - + = alternating sign, - = same sign
-// inout - used for input and output
-void DelayMem16::allpass(int inaddr, int outaddr, float feedback, float *inout) {
-    float it1 = (float)delay[(dp + outaddr) & (dlen - 1)] * 0.000030518f;
-    *inout += it1 * -feedback;
-    delay[(dp + inaddr) & (dlen - 1)] = (int16_t)(*inout * 32768.0f);
-    *inout = (*inout * feedback) + it1;
+// constructor - the min len is rounded up to the next
+// power of 2 and the memory is allocated
+DelayMemFloat16::DelayMemFloat16(int minLen) {
+    int len = 1;
+    while(len < minLen) {
+        len = len << 1;
+    }
+    Line::setBuffer((uint16_t *)malloc(sizeof(uint16_t) * len), len);
+    Line::clear();
+    preallocated = 0;
 }
 
-// inaddr - the address to write to
-// outaddr - the address to read from as a float - real = addr, fract = interp
-// feedback - AP feedback coeff
-// acc - used for input and output
-void DelayMem16::allpassFract(int inaddr, float outaddr, float feedback, float *inout) {
-    float it2 = outaddr - (int)outaddr;
-    float it1 = ((float)delay[(dp + (int)outaddr) & (dlen - 1)] * 0.000030518f) * (1.0 - it2);
-    it1 += ((float)delay[(dp + ((int)outaddr + 1)) & (dlen - 1)] * 0.000030518f) * it2;
-    *inout += (it1 * -feedback);
-    delay[(dp + inaddr) & (dlen - 1)] = (int16_t)(*inout * 32768.0f);
-    *inout = (*inout * feedback) + it1;
+// destructor
+DelayMemFloat16::~DelayMemFloat16() {
+    if(preallocated == 0) {
+        free(delay);
+    }
 }
 
 //
@@ -618,41 +1028,736 @@ int AudioBufferer::isFull(void) {
 FIRFilter::FIRFilter(int taps, float *coeffs) {
     int i;
     numtaps = taps;
-    hist = (float *)malloc(sizeof(float) * numtaps);
-    this->coeffs = (float *)malloc(sizeof(float) * numtaps);
+    histlen = (numtaps + 7) & ~7;
+    hist = (float *)alignedMalloc(sizeof(float) * histlen * 2, ALIGN);
+    this->coeffs = (float *)alignedMalloc(sizeof(float) * histlen, ALIGN);
     histpos = 0;
-    for(i = 0; i < numtaps; i ++) {
+    for(i = 0; i < histlen * 2; i ++) {
         hist[i] = 0.0f;
-        this->coeffs[i] = coeffs[i];
+    }
+    // the oldest sample lines up with the first coeff
+    for(i = 0; i < histlen; i ++) {
+        if(i < histlen - numtaps) {
+            this->coeffs[i] = 0.0f;
+        }
+        else {
+            this->coeffs[i] = coeffs[histlen - 1 - i];
+        }
     }
 }
 
 // destructor
 FIRFilter::~FIRFilter() {
-    free(hist);
-    free(coeffs);
+    alignedFree(hist);
+    alignedFree(coeffs);
 }
 
 // process a sample and returns next output sample
 float FIRFilter::process(float in) {
-    int i, n;
+    hist[histpos] = in;
+    hist[histpos + histlen] = in;
+    histpos ++;
+    if(histpos == histlen) histpos = 0;
+    // hist[histpos] is the oldest sample
+    return dotProduct8(coeffs, &hist[histpos], histlen);
+}
+
+// process a block
+void FIRFilter::process(const float *in, float *out, int len) {
+    int i, pos = histpos;
+    for(i = 0; i < len; i ++) {
+        hist[pos] = in[i];
+        hist[pos + histlen] = in[i];
+        pos ++;
+        if(pos == histlen) pos = 0;
+        out[i] = dotProduct8(coeffs, &hist[pos], histlen);
+    }
+    histpos = pos;
+}
+
+//
+// RealFFT
+//
+// constructor
+// size - the number of real samples - a power of 2 from 4
+RealFFT::RealFFT(int size) {
+    int i, j, bits;
+    this->size = size;
+    half = size / 2;
+    bitrev = (int *)malloc(sizeof(int) * half);
+    twr = (float *)alignedMalloc(sizeof(float) * half, FIRFilter::ALIGN);
+    twi = (float *)alignedMalloc(sizeof(float) * half, FIRFilter::ALIGN);
+    splr = (float *)alignedMalloc(sizeof(float) * (half + 1), FIRFilter::ALIGN);
+    spli = (float *)alignedMalloc(sizeof(float) * (half + 1), FIRFilter::ALIGN);
+    workr = (float *)alignedMalloc(sizeof(float) * half, FIRFilter::ALIGN);
+    worki = (float *)alignedMalloc(sizeof(float) * half, FIRFilter::ALIGN);
+    bits = 0;
+    while((1 << bits) < half) {
+        bits ++;
+    }
+    for(i = 0; i < half; i ++) {
+        bitrev[i] = 0;
+        for(j = 0; j < bits; j ++) {
+            if(i & (1 << j)) {
+                bitrev[i] |= 1 << (bits - 1 - j);
+            }
+        }
+        // exp(-2 pi i k / half)
+        twr[i] = cos(2.0 * M_PI * i / half);
+        twi[i] = -sin(2.0 * M_PI * i / half);
+    }
+    for(i = 0; i <= half; i ++) {
+        // exp(-2 pi i k / size)
+        splr[i] = cos(2.0 * M_PI * i / size);
+        spli[i] = -sin(2.0 * M_PI * i / size);
+    }
+}
+
+// destructor
+RealFFT::~RealFFT() {
+    free(bitrev);
+    alignedFree(twr);
+    alignedFree(twi);
+    alignedFree(splr);
+    alignedFree(spli);
+    alignedFree(workr);
+    alignedFree(worki);
+}
+
+// forward transform
+// the even / odd samples are packed into one complex FFT of half the
+// size and then split into the real spectrum
+void RealFFT::forward(const float *in, float *re, float *im) {
+    int k;
+    float ar, ai, br, bi, er, ei, or_, oi;
+    for(k = 0; k < half; k ++) {
+        workr[bitrev[k]] = in[k * 2];
+        worki[bitrev[k]] = in[k * 2 + 1];
+    }
+    complexFFT();
+    re[0] = workr[0] + worki[0];
+    im[0] = 0.0f;
+    re[half] = workr[0] - worki[0];
+    im[half] = 0.0f;
+    for(k = 1; k < half; k ++) {
+        ar = workr[k];
+        ai = worki[k];
+        br = workr[half - k];
+        bi = worki[half - k];
+        // even and odd sample spectra
+        er = (ar + br) * 0.5f;
+        ei = (ai - bi) * 0.5f;
+        or_ = (ai + bi) * 0.5f;
+        oi = (br - ar) * 0.5f;
+        re[k] = er + (splr[k] * or_) - (spli[k] * oi);
+        im[k] = ei + (splr[k] * oi) + (spli[k] * or_);
+    }
+}
+
+// inverse transform - scaled so that inverse(forward(x)) = x
+void RealFFT::inverse(const float *re, const float *im, float *out) {
+    int k;
+    float er, ei, dr, di, or_, oi, scale;
+    for(k = 0; k < half; k ++) {
+        er = (re[k] + re[half - k]) * 0.5f;
+        ei = (im[k] - im[half - k]) * 0.5f;
+        dr = (re[k] - re[half - k]) * 0.5f;
+        di = (im[k] + im[half - k]) * 0.5f;
+        // odd spectrum is the difference rotated back by exp(2 pi i k / size)
+        or_ = (dr * splr[k]) + (di * spli[k]);
+        oi = (di * splr[k]) - (dr * spli[k]);
+        // conjugate so the forward complex FFT runs the inverse
+        workr[bitrev[k]] = er - oi;
+        worki[bitrev[k]] = -(ei + or_);
+    }
+    complexFFT();
+    scale = 1.0f / (float)half;
+    for(k = 0; k < half; k ++) {
+        out[k * 2] = workr[k] * scale;
+        out[k * 2 + 1] = -worki[k] * scale;
+    }
+}
+
+// run the complex FFT on the work buffer in place
+// the input must already be in bit reversed order
+void RealFFT::complexFFT(void) {
+    int len, step, i, j, a, b;
+    float wr, wi, tr, ti;
+    for(len = 2; len <= half; len <<= 1) {
+        step = half / len;
+        for(i = 0; i < half; i += len) {
+            for(j = 0; j < len / 2; j ++) {
+                wr = twr[j * step];
+                wi = twi[j * step];
+                a = i + j;
+                b = a + len / 2;
+                tr = (workr[b] * wr) - (worki[b] * wi);
+                ti = (workr[b] * wi) + (worki[b] * wr);
+                workr[b] = workr[a] - tr;
+                worki[b] = worki[a] - ti;
+                workr[a] += tr;
+                worki[a] += ti;
+            }
+        }
+    }
+}
+
+//
+// FFTConvolver
+//
+// constructor
+// blockSize - the partition size - a power of 2 from 16 to 8192
+// ir - the impulse response (copied internally)
+// irlen - the impulse response length
+FFTConvolver::FFTConvolver(int blockSize, const float *ir, int irlen) {
+    int i, p, len;
+    float *temp;
+    int size = 16;
+    while(size < blockSize && size < 8192) {
+        size <<= 1;
+    }
+    this->blockSize = size;
+    bins = size + 1;
+    if(irlen < 1) {
+        irlen = 1;
+    }
+    parts = (irlen - 1) / size;
+    fft = new RealFFT(size * 2);
+    // head
+    len = (irlen < size) ? irlen : size;
+    temp = (float *)malloc(sizeof(float) * size * 2);
+    for(i = 0; i < len; i ++) {
+        temp[i] = ir[i];
+    }
+    head = new FIRFilter(len, temp);
+    // tail partitions - each is zero padded to the FFT size
+    hre = (float *)alignedMalloc(sizeof(float) * bins * (parts + 1), FIRFilter::ALIGN);
+    him = (float *)alignedMalloc(sizeof(float) * bins * (parts + 1), FIRFilter::ALIGN);
+    for(p = 0; p < parts; p ++) {
+        for(i = 0; i < size * 2; i ++) {
+            len = ((p + 1) * size) + i;
+            temp[i] = (i < size && len < irlen) ? ir[len] : 0.0f;
+        }
+        fft->forward(temp, &hre[p * bins], &him[p * bins]);
+    }
+    free(temp);
+    fdlre = (float *)alignedMalloc(sizeof(float) * bins * (parts + 1), FIRFilter::ALIGN);
+    fdlim = (float *)alignedMalloc(sizeof(float) * bins * (parts + 1), FIRFilter::ALIGN);
+    accre = (float *)alignedMalloc(sizeof(float) * bins, FIRFilter::ALIGN);
+    accim = (float *)alignedMalloc(sizeof(float) * bins, FIRFilter::ALIGN);
+    window = (float *)alignedMalloc(sizeof(float) * size * 2, FIRFilter::ALIGN);
+    tail = (float *)alignedMalloc(sizeof(float) * size, FIRFilter::ALIGN);
+    work = (float *)alignedMalloc(sizeof(float) * size * 2, FIRFilter::ALIGN);
+    reset();
+}
+
+// destructor
+FFTConvolver::~FFTConvolver() {
+    delete fft;
+    delete head;
+    alignedFree(hre);
+    alignedFree(him);
+    alignedFree(fdlre);
+    alignedFree(fdlim);
+    alignedFree(accre);
+    alignedFree(accim);
+    alignedFree(window);
+    alignedFree(tail);
+    alignedFree(work);
+}
+
+// clear the history
+void FFTConvolver::reset(void) {
+    int i;
+    for(i = 0; i < bins * (parts + 1); i ++) {
+        fdlre[i] = 0.0f;
+        fdlim[i] = 0.0f;
+    }
+    for(i = 0; i < blockSize * 2; i ++) {
+        window[i] = 0.0f;
+    }
+    for(i = 0; i < blockSize; i ++) {
+        tail[i] = 0.0f;
+    }
+    for(i = 0; i < head->histlen * 2; i ++) {
+        head->hist[i] = 0.0f;
+    }
+    head->histpos = 0;
+    pos = 0;
+    fdlpos = 0;
+}
+
+// process a sample and returns next output sample
+float FFTConvolver::process(float in) {
+    float out;
+    window[blockSize + pos] = in;
+    out = head->process(in) + tail[pos];
+    pos ++;
+    if(pos == blockSize) {
+        processTail();
+        pos = 0;
+    }
+    return out;
+}
+
+// process a block
+void FFTConvolver::process(const float *in, float *out, int len) {
+    int i, run;
+    while(len > 0) {
+        run = blockSize - pos;
+        if(run > len) {
+            run = len;
+        }
+        for(i = 0; i < run; i ++) {
+            window[blockSize + pos + i] = in[i];
+        }
+        head->process(in, out, run);
+        for(i = 0; i < run; i ++) {
+            out[i] += tail[pos + i];
+        }
+        pos += run;
+        if(pos == blockSize) {
+            processTail();
+            pos = 0;
+        }
+        in += run;
+        out += run;
+        len -= run;
+    }
+}
+
+// run the tail partitions at the end of a block
+// the output for the next block only needs the input blocks up to this
+// one because the head FIR covers the first partition
+void FFTConvolver::processTail(void) {
+    int i, p, slot;
+    const float *xr, *xi, *hr, *hi;
+    if(parts == 0) {
+        return;
+    }
+    // transform the newest window into the delay line
+    fft->forward(window, &fdlre[fdlpos * bins], &fdlim[fdlpos * bins]);
+    for(i = 0; i < blockSize; i ++) {
+        window[i] = window[blockSize + i];
+    }
+    // multiply each past input block by its partition
+    for(i = 0; i < bins; i ++) {
+        accre[i] = 0.0f;
+        accim[i] = 0.0f;
+    }
+    slot = fdlpos;
+    for(p = 0; p < parts; p ++) {
+        xr = &fdlre[slot * bins];
+        xi = &fdlim[slot * bins];
+        hr = &hre[p * bins];
+        hi = &him[p * bins];
+        for(i = 0; i < bins; i ++) {
+            accre[i] += (xr[i] * hr[i]) - (xi[i] * hi[i]);
+            accim[i] += (xr[i] * hi[i]) + (xi[i] * hr[i]);
+        }
+        slot --;
+        if(slot < 0) slot = parts - 1;
+    }
+    fdlpos ++;
+    if(fdlpos == parts) fdlpos = 0;
+    // the last half of the circular convolution is valid
+    fft->inverse(accre, accim, work);
+    for(i = 0; i < blockSize; i ++) {
+        tail[i] = work[blockSize + i];
+    }
+}
+
+//
+// PolyphaseDecimator
+//
+// constructor
+PolyphaseDecimator::PolyphaseDecimator() {
+    setFactor(1);
+}
+
+// set the decimation factor - 1 to MAX_FACTOR
+// this designs the filter and clears the history
+void PolyphaseDecimator::setFactor(int factor) {
+    int i;
+    float temp[MAX_TAPS];
+    if(factor < 1) factor = 1;
+    if(factor > MAX_FACTOR) factor = MAX_FACTOR;
+    this->factor = factor;
+    numtaps = factor * TAPS_PER_PHASE;
+    // cut off below the low rate nyquist so the transition band fits
+    designLowpassFIR(temp, numtaps, 0.33f / (float)factor);
+    for(i = 0; i < numtaps; i ++) {
+        coeffs[i] = temp[numtaps - 1 - i];
+    }
+    for(i = 0; i < numtaps * 2; i ++) {
+        hist[i] = 0.0f;
+    }
+    histpos = 0;
+    phase = 0;
+}
+
+// process an input sample
+// returns 1 and sets out when an output sample is ready
+int PolyphaseDecimator::process(float in, float *out) {
+    int i;
     float sum;
+    hist[histpos] = in;
+    hist[histpos + numtaps] = in;
+    histpos ++;
+    if(histpos == numtaps) histpos = 0;
+    phase ++;
+    if(phase < factor) {
+        return 0;
+    }
+    phase = 0;
+    // hist[histpos] is the oldest sample
+    const float *x = &hist[histpos];
+    sum = 0.0f;
+    for(i = 0; i < numtaps; i ++) {
+        sum += coeffs[i] * x[i];
+    }
+    *out = sum;
+    return 1;
+}
 
+//
+// PolyphaseInterpolator
+//
+// constructor
+PolyphaseInterpolator::PolyphaseInterpolator() {
+    setFactor(1);
+}
+
+// set the interpolation factor - 1 to MAX_FACTOR
+// this designs the filter and clears the history
+void PolyphaseInterpolator::setFactor(int factor) {
+    int i, p, k;
+    float temp[MAX_FACTOR * TAPS_PER_PHASE];
+    if(factor < 1) factor = 1;
+    if(factor > MAX_FACTOR) factor = MAX_FACTOR;
+    this->factor = factor;
+    designLowpassFIR(temp, factor * TAPS_PER_PHASE, 0.33f / (float)factor);
+    // split into phases - phase p uses taps p, p + factor, p + 2 * factor...
+    // and each phase is reversed and gained up to make up for the zero stuffing
+    for(p = 0; p < factor; p ++) {
+        for(k = 0; k < TAPS_PER_PHASE; k ++) {
+            coeffs[(p * TAPS_PER_PHASE) + (TAPS_PER_PHASE - 1 - k)] =
+                temp[(k * factor) + p] * (float)factor;
+        }
+    }
+    for(i = 0; i < TAPS_PER_PHASE * 2; i ++) {
+        hist[i] = 0.0f;
+    }
+    histpos = 0;
+    phase = 0;
+}
+
+// push an input sample at the low rate
+void PolyphaseInterpolator::push(float in) {
     hist[histpos] = in;
+    hist[histpos + TAPS_PER_PHASE] = in;
+    histpos ++;
+    if(histpos == TAPS_PER_PHASE) histpos = 0;
+    phase = 0;
+}
+
+// get the next output sample at the high rate
+// call this factor times after each push()
+float PolyphaseInterpolator::process(void) {
+    int i;
+    float sum = 0.0f;
+    // hist[histpos] is the oldest sample
+    const float *x = &hist[histpos];
+    const float *c = &coeffs[phase * TAPS_PER_PHASE];
+    for(i = 0; i < TAPS_PER_PHASE; i ++) {
+        sum += c[i] * x[i];
+    }
+    if(phase < factor - 1) {
+        phase ++;
+    }
+    return sum;
+}
+
+// allocate memory aligned for vector loads - free with alignedFree()
+// the pointer from malloc() is kept just before the aligned block
+void *dsp2::alignedMalloc(size_t size, int align) {
+    uintptr_t addr;
+    void *mem = malloc(size + align + sizeof(void *));
+    if(mem == NULL) {
+        return NULL;
+    }
+    addr = ((uintptr_t)mem + sizeof(void *) + align - 1) & ~((uintptr_t)align - 1);
+    ((void **)addr)[-1] = mem;
+    return (void *)addr;
+}
+
+// free memory from alignedMalloc()
+void dsp2::alignedFree(void *ptr) {
+    if(ptr != NULL) {
+        free(((void **)ptr)[-1]);
+    }
+}
+
+// design a windowed-sinc lowpass FIR
+// coeffs - the array to fill in with numtaps coeffs
+// cutoff - cutoff frequency as a fraction of the samplerate (0.0 to 0.5)
+// the DC gain is normalized to 1.0
+void dsp2::designLowpassFIR(float *coeffs, int numtaps, float cutoff) {
+    int i;
+    double x, w, sum;
+    double centre = (numtaps - 1) * 0.5;
+    sum = 0.0;
+    for(i = 0; i < numtaps; i ++) {
+        x = (double)i - centre;
+        // sinc
+        if(fabs(x) < 1.0e-9) {
+            coeffs[i] = 2.0 * cutoff;
+        }
+        else {
+            coeffs[i] = sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        }
+        // blackman window
+        if(numtaps > 1) {
+            w = 0.42 - 0.5 * cos(2.0 * M_PI * i / (numtaps - 1)) +
+                0.08 * cos(4.0 * M_PI * i / (numtaps - 1));
+        }
+        else {
+            w = 1.0;
+        }
+        coeffs[i] *= w;
+        sum += coeffs[i];
+    }
+    for(i = 0; i < numtaps; i ++) {
+        coeffs[i] /= sum;
+    }
+}
+
+// zero order modified Bessel function for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    int k;
+    for(k = 1; k < 50; k ++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// design a half-band lowpass FIR
+// returns the number of coeffs
+int dsp2::designHalfbandFIR(float *coeffs, int quality, int stage) {
+    // taps for the first stage, taps for later stages, Kaiser beta
+    static const int presets[HALFBAND_NUM_QUALITY][3] = {
+        {8, 4, 5},
+        {12, 6, 7},
+        {16, 8, 9}
+    };
+    int j, m, taps;
+    double r, sum;
+    if(quality < 0) quality = 0;
+    if(quality >= HALFBAND_NUM_QUALITY) quality = HALFBAND_NUM_QUALITY - 1;
+    taps = presets[quality][stage ? 1 : 0];
     sum = 0.0;
-    n = 0;
+    for(j = 0; j < taps; j ++) {
+        m = (j * 2) + 1;
+        r = (double)m / (double)(taps * 2);
+        coeffs[j] = sin(M_PI * m * 0.5) / (M_PI * m) *
+            besselI0(presets[quality][2] * sqrt(1.0 - r * r)) /
+            besselI0(presets[quality][2]);
+        sum += coeffs[j];
+    }
+    // the odd taps on both sides add up to 0.5 for unity DC gain
+    for(j = 0; j < taps; j ++) {
+        coeffs[j] *= 0.25 / sum;
+    }
+    return taps;
+}
+
+//
+// HalfbandInterpolator
+//
+// constructor
+HalfbandInterpolator::HalfbandInterpolator() {
+    setQuality(HALFBAND_MEDIUM, 0);
+}
 
-    for(i = histpos; i >= 0; i --) {
-        sum += coeffs[n++] * hist[i];
+// set the quality - this designs the filter and clears the history
+void HalfbandInterpolator::setQuality(int quality, int stage) {
+    int i;
+    taps = designHalfbandFIR(coeffs, quality, stage);
+    // make up for the zero stuffing
+    for(i = 0; i < taps; i ++) {
+        coeffs[i] *= 2.0f;
     }
-    for(i = numtaps - 1; i > histpos; i --) {
-        sum += coeffs[n++] * hist[i];
+    for(i = 0; i < MAX_TAPS * 4; i ++) {
+        hist[i] = 0.0f;
     }
+    histpos = 0;
+}
+
+// get the latency in output samples
+int HalfbandInterpolator::getLatency(void) {
+    return (taps * 2) - 1;
+}
+
+// process an input sample
+void HalfbandInterpolator::process(float in, float *out) {
+    int j;
+    float sum = 0.0f;
+    int len = taps * 2;
+    hist[histpos] = in;
+    hist[histpos + len] = in;
     histpos ++;
-    if(histpos == numtaps) histpos = 0;
+    if(histpos == len) histpos = 0;
+    // x[0] is the oldest sample - the taps pair up around the centre
+    const float *x = &hist[histpos];
+    for(j = 0; j < taps; j ++) {
+        sum += coeffs[j] * (x[taps + j] + x[taps - 1 - j]);
+    }
+    out[0] = sum;
+    out[1] = x[taps];
+}
+
+// process a block
+void HalfbandInterpolator::processBlock(const float *in, float *out, int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        process(in[i], &out[i * 2]);
+    }
+}
+
+//
+// HalfbandDecimator
+//
+// constructor
+HalfbandDecimator::HalfbandDecimator() {
+    setQuality(HALFBAND_MEDIUM, 0);
+}
+
+// set the quality - this designs the filter and clears the history
+void HalfbandDecimator::setQuality(int quality, int stage) {
+    int i;
+    taps = designHalfbandFIR(coeffs, quality, stage);
+    for(i = 0; i < MAX_TAPS * 4; i ++) {
+        even[i] = 0.0f;
+        odd[i] = 0.0f;
+    }
+    histpos = 0;
+}
+
+// get the latency in input samples
+int HalfbandDecimator::getLatency(void) {
+    return (taps * 2) - 1;
+}
+
+// process a pair of input samples
+float HalfbandDecimator::process(const float *in) {
+    int j;
+    float sum;
+    int len = taps * 2;
+    even[histpos] = in[0];
+    even[histpos + len] = in[0];
+    odd[histpos] = in[1];
+    odd[histpos + len] = in[1];
+    histpos ++;
+    if(histpos == len) histpos = 0;
+    // x[0] is the oldest sample - the taps pair up around the centre
+    // which falls on an odd sample
+    const float *x = &even[histpos];
+    sum = odd[histpos + taps - 1] * 0.5f;
+    for(j = 0; j < taps; j ++) {
+        sum += coeffs[j] * (x[taps + j] + x[taps - 1 - j]);
+    }
     return sum;
 }
 
+// process a block
+void HalfbandDecimator::processBlock(const float *in, float *out, int len) {
+    int i;
+    for(i = 0; i < len; i ++) {
+        out[i] = process(&in[i * 2]);
+    }
+}
+
+//
+// Oversampler
+//
+// constructor
+Oversampler::Oversampler() {
+    setFactor(2, HALFBAND_MEDIUM);
+}
+
+// set the factor and quality - this clears the history
+void Oversampler::setFactor(int factor, int quality) {
+    if(factor < 2) factor = 1;
+    else if(factor < 4) factor = 2;
+    else factor = 4;
+    this->factor = factor;
+    up[0].setQuality(quality, 0);
+    up[1].setQuality(quality, 1);
+    down[0].setQuality(quality, 0);
+    down[1].setQuality(quality, 1);
+}
+
+// get the latency of upsample() and downsample() together
+float Oversampler::getLatency(void) {
+    switch(factor) {
+        case 2:
+            return (float)(up[0].getLatency() + down[0].getLatency()) * 0.5f;
+        case 4:
+            return (float)(up[0].getLatency() + down[0].getLatency()) * 0.5f +
+                (float)(up[1].getLatency() + down[1].getLatency()) * 0.25f;
+        default:
+            return 0.0f;
+    }
+}
+
+// upsample a block
+void Oversampler::upsample(const float *in, float *out, int len) {
+    int run;
+    while(len > 0) {
+        run = (len < BLOCK) ? len : BLOCK;
+        switch(factor) {
+            case 2:
+                up[0].processBlock(in, out, run);
+                break;
+            case 4:
+                up[0].processBlock(in, temp, run);
+                up[1].processBlock(temp, out, run * 2);
+                break;
+            default:
+                memcpy(out, in, sizeof(float) * run);
+                break;
+        }
+        in += run;
+        out += run * factor;
+        len -= run;
+    }
+}
+
+// downsample a block
+void Oversampler::downsample(const float *in, float *out, int len) {
+    int run;
+    while(len > 0) {
+        run = (len < BLOCK) ? len : BLOCK;
+        switch(factor) {
+            case 2:
+                down[0].processBlock(in, out, run);
+                break;
+            case 4:
+                down[1].processBlock(in, temp, run * 2);
+                down[0].processBlock(temp, out, run);
+                break;
+            default:
+                memcpy(out, in, sizeof(float) * run);
+                break;
+        }
+        in += run * factor;
+        out += run;
+        len -= run;
+    }
+}
+
 //
 // AllpassSection
 //
@@ -683,19 +1788,35 @@ float AllpassSection::process(float in) {
 //
 // AllpassPhaseShifter
 //
+// phase reference path coeffs
+const float AllpassPhaseShifter::PR_COEFF[SECTIONS] = {
+    0.48660436861367767358,
+    0.88077943527246449484,
+    0.97793125561632343601,
+    0.99767386185073303473
+};
+
+// phase shift path coeffs
+const float AllpassPhaseShifter::SH_COEFF[SECTIONS] = {
+    0.16514909355907719801,
+    0.73982901254452670958,
+    0.94794090632917971107,
+    0.99120971270525837227
+};
+
 // constructor
 AllpassPhaseShifter::AllpassPhaseShifter() {
     pr_del = 0.0f;
 
-    pr0.setCoeff(0.48660436861367767358);
-    pr1.setCoeff(0.88077943527246449484);
-    pr2.setCoeff(0.97793125561632343601);
-    pr3.setCoeff(0.99767386185073303473);
+    pr0.setCoeff(PR_COEFF[0]);
+    pr1.setCoeff(PR_COEFF[1]);
+    pr2.setCoeff(PR_COEFF[2]);
+    pr3.setCoeff(PR_COEFF[3]);
 
-    sh0.setCoeff(0.16514909355907719801);
-    sh1.setCoeff(0.73982901254452670958);
-    sh2.setCoeff(0.94794090632917971107);
-    sh3.setCoeff(0.99120971270525837227);
+    sh0.setCoeff(SH_COEFF[0]);
+    sh1.setCoeff(SH_COEFF[1]);
+    sh2.setCoeff(SH_COEFF[2]);
+    sh3.setCoeff(SH_COEFF[3]);
 }
 
 // process a sample and returns next output sample
@@ -719,6 +1840,116 @@ void AllpassPhaseShifter::process(float in, float *del, float *shift) {
     *shift = sh3.process(tempf);
 }
 
+//
+// AllpassPhaseShifterVec
+//
+// constructor
+AllpassPhaseShifterVec::AllpassPhaseShifterVec() {
+    s0.setCoeff(0, AllpassPhaseShifter::PR_COEFF[0]);
+    s1.setCoeff(0, AllpassPhaseShifter::PR_COEFF[1]);
+    s2.setCoeff(0, AllpassPhaseShifter::PR_COEFF[2]);
+    s3.setCoeff(0, AllpassPhaseShifter::PR_COEFF[3]);
+    s0.setCoeff(1, AllpassPhaseShifter::SH_COEFF[0]);
+    s1.setCoeff(1, AllpassPhaseShifter::SH_COEFF[1]);
+    s2.setCoeff(1, AllpassPhaseShifter::SH_COEFF[2]);
+    s3.setCoeff(1, AllpassPhaseShifter::SH_COEFF[3]);
+    pr_del = 0.0f;
+}
+
+// process a sample and returns next output sample
+// del = delayed, in phase
+// shift = delayed, +90deg. phase shift (early)
+void AllpassPhaseShifterVec::process(float in, float *del, float *shift) {
+    Float4Vec temp;
+
+    // both paths at once
+    temp = s0.process(Float4Vec{in, in, 0.0f, 0.0f});
+    temp = s1.process(temp);
+    temp = s2.process(temp);
+    temp = s3.process(temp);
+    *del = pr_del;  // 1 sample delay
+    pr_del = temp[0];
+    *shift = temp[1];
+}
+
+//
+// AllpassPhaseShifterPipelined
+//
+// constructor
+AllpassPhaseShifterPipelined::AllpassPhaseShifterPipelined() {
+    int i;
+    for(i = 0; i < AllpassPhaseShifter::SECTIONS; i ++) {
+        pr.setCoeff(i, AllpassPhaseShifter::PR_COEFF[i]);
+        sh.setCoeff(i, AllpassPhaseShifter::SH_COEFF[i]);
+    }
+    pr_out = Float4Vec{};
+    sh_out = Float4Vec{};
+    pr_del = 0.0f;
+}
+
+// process a sample and returns next output sample
+// del = delayed, in phase
+// shift = delayed, +90deg. phase shift (early)
+void AllpassPhaseShifterPipelined::process(float in, float *del, float *shift) {
+    // phase reference path - each section takes the last output of the one before
+    pr_out = pr.process(Float4Vec{in, pr_out[0], pr_out[1], pr_out[2]});
+    *del = pr_del;  // 1 sample delay
+    pr_del = pr_out[3];
+
+    // phase shifter +90 path
+    sh_out = sh.process(Float4Vec{in, sh_out[0], sh_out[1], sh_out[2]});
+    *shift = sh_out[3];
+}
+
+//
+// AllpassPhaseShifter4
+//
+// constructor
+AllpassPhaseShifter4::AllpassPhaseShifter4() {
+    int i;
+    for(i = 0; i < 4; i ++) {
+        pr0.setCoeff(i, AllpassPhaseShifter::PR_COEFF[0]);
+        pr1.setCoeff(i, AllpassPhaseShifter::PR_COEFF[1]);
+        pr2.setCoeff(i, AllpassPhaseShifter::PR_COEFF[2]);
+        pr3.setCoeff(i, AllpassPhaseShifter::PR_COEFF[3]);
+        sh0.setCoeff(i, AllpassPhaseShifter::SH_COEFF[0]);
+        sh1.setCoeff(i, AllpassPhaseShifter::SH_COEFF[1]);
+        sh2.setCoeff(i, AllpassPhaseShifter::SH_COEFF[2]);
+        sh3.setCoeff(i, AllpassPhaseShifter::SH_COEFF[3]);
+    }
+    pr_del = Float4Vec{};
+}
+
+// process a sample on each channel
+// del = delayed, in phase
+// shift = delayed, +90deg. phase shift (early)
+void AllpassPhaseShifter4::process(Float4Vec in, Float4Vec *del, Float4Vec *shift) {
+    Float4Vec temp;
+
+    // phase reference path
+    temp = pr0.process(in);
+    temp = pr1.process(temp);
+    temp = pr2.process(temp);
+    temp = pr3.process(temp);
+    *del = pr_del;  // 1 sample delay
+    pr_del = temp;
+
+    // phase shifter +90 path
+    temp = sh0.process(in);
+    temp = sh1.process(temp);
+    temp = sh2.process(temp);
+    *shift = sh3.process(temp);
+}
+
+// process a sample on each channel
+void AllpassPhaseShifter4::process(const float *in, float *del, float *shift) {
+    Float4Vec vin, vdel, vshift;
+    memcpy(&vin, in, sizeof(vin));
+    process(vin, &vdel, &vshift);
+    memcpy(del, &vdel, sizeof(vdel));
+    memcpy(shift, &vshift, sizeof(vshift));
+}
+
 //
 // FastSineGen
 //
@@ -11,8 +11,13 @@
 #define DSP_UTILS2_H
 
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 #include <string>
 #include <vector>
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
 #include "PLog.h"
 
 // portable PC-centric C++ here - no VCV functions
@@ -181,6 +186,23 @@ inline float adjustTimeFactorCoarse(float currentVal, float change) {
     return (float)ms * 0.001f;
 }
 
+// fast tan(pi * x) for filter design - a [5/4] pade approximation
+// reflected about x = 0.25 so that it holds up to nyquist
+// x - normalized frequency (freq / fs) - range: 0.0f to 0.499f
+// max relative error vs. tan(): 3e-7 (about 2 float ulps)
+inline float fastTanPi(float x) {
+    float w, w2, num, den;
+    int flip = x > 0.25f;
+    if(flip) {
+        x = 0.5f - x;
+    }
+    w = x * (float)M_PI;
+    w2 = w * w;
+    num = w * (945.0f + w2 * (-105.0f + w2));
+    den = 945.0f + w2 * (-420.0f + w2 * 15.0f);
+    return flip ? den / num : num / den;
+}
+
 // a level sense structured like a 1 pole LPF
 struct LevelSense {
     float a0Attack = 0.0f;
@@ -195,6 +217,17 @@ struct LevelSense {
 
     // run 1-pole lowpass
     float process(float in);
+
+    // run 1-pole lowpass on a block
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void processBlock(const float *in, float *out, int len);
+
+    // run 1-pole lowpass on a block in place
+    void processBlock(float *inout, int len) {
+        processBlock(inout, inout, len);
+    }
 };
 
 // single pole filter
@@ -211,6 +244,28 @@ struct Filter1Pole {
     // run 1-pole highpass
     float highpass(float in);
 
+    // run 1-pole lowpass on a block
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void lowpassBlock(const float *in, float *out, int len);
+
+    // run 1-pole lowpass on a block in place
+    void lowpassBlock(float *inout, int len) {
+        lowpassBlock(inout, inout, len);
+    }
+
+    // run 1-pole highpass on a block
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void highpassBlock(const float *in, float *out, int len);
+
+    // run 1-pole highpass on a block in place
+    void highpassBlock(float *inout, int len) {
+        highpassBlock(inout, inout, len);
+    }
+
     // get the most recently computied out
     float getOutput(void);
 };
@@ -224,6 +279,13 @@ struct Filter2Pole {
     float b2 = 0.0f;
     float z1 = 0.0f;
     float z2 = 0.0f;
+    // coeff ramp for modulation
+    float da0 = 0.0f;
+    float da1 = 0.0f;
+    float da2 = 0.0f;
+    float db1 = 0.0f;
+    float db2 = 0.0f;
+    int rampCount = 0;
     // values for string
     float freq = 0.0f;
     float gain = 0.0f;
@@ -248,9 +310,54 @@ struct Filter2Pole {
     void setCutoff(int type, float freq, float q,
         float gain, float fs);
 
+    // set the filter cutoff for modulation - cheap enough to call at
+    // audio rate and the state is kept so sweeps don't click
+    // uses fastTanPi() so the coeffs are within about 1e-6 of setCutoff()
+    // type: filter type
+    // freq: frequency in Hz - range: 0.0f to 0.499f * fs
+    // q: Q factor
+    // gain: gain factor
+    // fs: audio samplerate in Hz
+    void setCutoffFast(int type, float freq, float q,
+        float gain, float fs);
+
+    // ramp the filter cutoff for modulation from a control rate update
+    // the coeffs move linearly to the new values over a number of calls
+    // to processRamp() - the stable region of b1 / b2 is convex so every
+    // step is stable if both ends are
+    // type: filter type
+    // freq: frequency in Hz - range: 0.0f to 0.499f * fs
+    // q: Q factor
+    // gain: gain factor
+    // fs: audio samplerate in Hz
+    // samples: the number of calls to processRamp() to reach the new coeffs
+    void setCutoffRamp(int type, float freq, float q,
+        float gain, float fs, int samples);
+
+    // set the coeffs
+    // type: filter type
+    // K: tan(pi * freq / fs)
+    // q: Q factor
+    // gain: gain factor
+    void setCoeffs(int type, float K, float q, float gain);
+
     // process a sample
     float process(float in);
 
+    // process a sample and step the coeff ramp
+    float processRamp(float in);
+
+    // process a block
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void processBlock(const float *in, float *out, int len);
+
+    // process a block in place
+    void processBlock(float *inout, int len) {
+        processBlock(inout, inout, len);
+    }
+
     // get the frequency as a string
     std::string getFreqStr(void);
 
@@ -261,6 +368,174 @@ struct Filter2Pole {
     std::string getQStr(void);
 };
 
+// vectors of 4 and 8 floats - 16 byte alignment so that structs
+// containing them can be allocated with new
+typedef float Float4Vec __attribute__((vector_size(16)));
+typedef float Float8Vec __attribute__((vector_size(32), aligned(16)));
+
+// vector type for a number of lanes
+template <int Lanes> struct LaneVec { };
+template <> struct LaneVec<4> { typedef Float4Vec type; };
+template <> struct LaneVec<8> { typedef Float8Vec type; };
+
+// bank of 2 pole filters processed in parallel - one filter per lane
+// the coefficients and state are stored as vectors of lanes so each
+// step of the filter runs all lanes in one instruction (or two for 8
+// lanes on SSE only builds)
+// Lanes - the number of filters: 4 or 8
+template <int Lanes = 4>
+struct Filter2PoleBank {
+    typedef typename LaneVec<Lanes>::type vec;
+    vec a0, a1, a2, b1, b2;  // coeffs
+    vec z1, z2;  // state
+
+    // constructor - all lanes pass nothing until set
+    Filter2PoleBank() {
+        a0 = vec{};
+        a1 = vec{};
+        a2 = vec{};
+        b1 = vec{};
+        b2 = vec{};
+        reset();
+    }
+
+    // set the filter cutoff of one lane and clear its state
+    // lane: the lane to set
+    // type: filter type - Filter2Pole::TYPE_*
+    // freq: frequency in Hz
+    // q: Q factor
+    // gain: gain factor
+    // fs: audio samplerate in Hz
+    void setCutoff(int lane, int type, float freq, float q,
+            float gain, float fs) {
+        Filter2Pole filt;
+        filt.setCutoff(type, freq, q, gain, fs);
+        a0[lane] = filt.a0;
+        a1[lane] = filt.a1;
+        a2[lane] = filt.a2;
+        b1[lane] = filt.b1;
+        b2[lane] = filt.b2;
+        z1[lane] = 0.0f;
+        z2[lane] = 0.0f;
+    }
+
+    // set the filter cutoff of all lanes and clear the state
+    void setCutoff(int type, float freq, float q, float gain, float fs) {
+        int i;
+        for(i = 0; i < Lanes; i ++) {
+            setCutoff(i, type, freq, q, gain, fs);
+        }
+    }
+
+    // clear the state of all lanes
+    void reset(void) {
+        z1 = vec{};
+        z2 = vec{};
+    }
+
+    // process a sample on each lane
+    // inout - used for input and output
+    inline void process(vec &inout) {
+        vec in = inout;
+        inout = (in * a0) + z1;
+        z1 = (in * a1) + z2 - (inout * b1);
+        z2 = (in * a2) - (inout * b2);
+    }
+
+    // process a frame - one sample per lane
+    // in - Lanes input samples
+    // out - Lanes output samples - can be the same as in
+    inline void process(const float *in, float *out) {
+        vec val;
+        memcpy(&val, in, sizeof(val));
+        process(val);
+        memcpy(out, &val, sizeof(val));
+    }
+
+    // process a block of interleaved frames
+    // in - frames * Lanes input samples
+    // out - frames * Lanes output samples - can be the same as in
+    // frames - the number of frames
+    void processBlock(const float *in, float *out, int frames) {
+        int i;
+        for(i = 0; i < frames; i ++) {
+            process(&in[i * Lanes], &out[i * Lanes]);
+        }
+    }
+};
+
+// cascade of up to 4 2 pole sections for high order filters
+// each section runs in its own lane and the samples are pipelined so
+// lane k works on the sample from k samples ago - all sections run
+// in one vector op per sample with a fixed latency of 3 samples
+// unused sections pass the signal through
+struct Filter2PoleCascade {
+    static constexpr int SECTIONS = 4;
+    static constexpr int LATENCY = SECTIONS - 1;
+    Float4Vec a0, a1, a2, b1, b2;  // coeffs per section
+    Float4Vec z1, z2;  // state per section
+    Float4Vec x;  // the next input to each section
+
+    // constructor - all sections pass through
+    Filter2PoleCascade();
+
+    // set one section to a Filter2Pole design and clear its state
+    // section: the section - range: 0 to SECTIONS - 1
+    // type: filter type - Filter2Pole::TYPE_*
+    // freq: frequency in Hz
+    // q: Q factor
+    // gain: gain factor
+    // fs: audio samplerate in Hz
+    void setSection(int section, int type, float freq, float q,
+        float gain, float fs);
+
+    // set one section to pass the signal through
+    void setBypass(int section);
+
+    // set a Butterworth filter
+    // type: Filter2Pole::TYPE_LPF or Filter2Pole::TYPE_HPF
+    // order: filter order - 2, 4, 6 or 8
+    // freq: -3dB frequency in Hz
+    // fs: audio samplerate in Hz
+    // returns -1 on error, 0 on success
+    int setButterworth(int type, int order, float freq, float fs);
+
+    // set a Linkwitz-Riley filter - two Butterworth filters in series
+    // type: Filter2Pole::TYPE_LPF or Filter2Pole::TYPE_HPF
+    // order: filter order - 4 or 8
+    // freq: -6dB crossover frequency in Hz
+    // fs: audio samplerate in Hz
+    // returns -1 on error, 0 on success
+    int setLinkwitzRiley(int type, int order, float freq, float fs);
+
+    // clear the state
+    void reset(void);
+
+    // process a sample - the output is delayed by LATENCY samples
+    inline float process(float in) {
+        Float4Vec v = x, y;
+        // insert the input in a register - writing one lane of the
+        // member stalls the vector load that follows
+        v[0] = in;
+        y = (v * a0) + z1;
+        z1 = (v * a1) + z2 - (y * b1);
+        z2 = (v * a2) - (y * b2);
+        x = Float4Vec{0.0f, y[0], y[1], y[2]};
+        return y[3];
+    }
+
+    // process a block - the output is delayed by LATENCY samples
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void processBlock(const float *in, float *out, int len);
+
+    // process a block in place
+    void processBlock(float *inout, int len) {
+        processBlock(inout, inout, len);
+    }
+};
+
 // levelmeter with peak hold
 struct Levelmeter {
     float hist;
@@ -351,19 +626,501 @@ struct SimpleLFO {
     float getPhaseShiftedOutput(float phase);
 };
 
-// delay memory with rotating and interpolation
-struct DelayMem {
+// delay line storage - float
+struct DelayStorageFloat {
+    typedef float type;
+
+    // convert stored value to float
+    static inline float load(float in) {
+        return in;
+    }
+
+    // convert float to stored value
+    static inline float store(float in) {
+        return in;
+    }
+
+    // convert a block of stored values - addresses run down from in
+    static inline void loadBlock(const float *in, float *out, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[i] = in[-i];
+        }
+    }
+
+    // convert a block to stored values - addresses run down from out
+    static inline void storeBlock(float *out, const float *in, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[-i] = in[i];
+        }
+    }
+};
+
+// delay line storage - 16 bit - range: -1.0f to +1.0f
+struct DelayStorage16 {
+    typedef int16_t type;
+
+    // convert stored value to float
+    static inline float load(int16_t in) {
+        return (float)in * 0.000030518f;
+    }
+
+    // convert float to stored value with saturation
+    static inline int16_t store(float in) {
+        int32_t val = (int32_t)(in * 32768.0f);
+        if(val > 32767) return 32767;
+        if(val < -32768) return -32768;
+        return (int16_t)val;
+    }
+
+    // convert a block of stored values - addresses run down from in
+    static inline void loadBlock(const int16_t *in, float *out, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[i] = load(in[-i]);
+        }
+    }
+
+    // convert a block to stored values - addresses run down from out
+    static inline void storeBlock(int16_t *out, const float *in, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[-i] = store(in[i]);
+        }
+    }
+};
+
+// delay line storage - IEEE half float - range: +/-65504.0f
+// uses F16C on x86 and native conversion on ARM64 if available,
+// otherwise the conversion is done in software and is slow
+struct DelayStorageHalf {
+    typedef uint16_t type;
+
+    // convert stored value to float
+    static inline float load(uint16_t in) {
+#if defined(__F16C__)
+        return _cvtsh_ss(in);
+#elif defined(__aarch64__)
+        __fp16 val;
+        memcpy(&val, &in, sizeof(val));
+        return (float)val;
+#else
+        uint32_t sign = (uint32_t)(in & 0x8000) << 16;
+        uint32_t exp = (in >> 10) & 0x1f;
+        uint32_t mant = in & 0x3ff;
+        uint32_t bits;
+        float out;
+        // inf / nan
+        if(exp == 0x1f) {
+            bits = sign | 0x7f800000 | (mant << 13);
+        }
+        // zero / subnormal
+        else if(exp == 0) {
+            out = (float)mant * 5.9604645e-8f;
+            return sign ? -out : out;
+        }
+        else {
+            bits = sign | ((exp + 112) << 23) | (mant << 13);
+        }
+        memcpy(&out, &bits, sizeof(out));
+        return out;
+#endif
+    }
+
+    // convert float to stored value - round to nearest
+    static inline uint16_t store(float in) {
+#if defined(__F16C__)
+        return _cvtss_sh(in, _MM_FROUND_TO_NEAREST_INT);
+#elif defined(__aarch64__)
+        __fp16 val = (__fp16)in;
+        uint16_t out;
+        memcpy(&out, &val, sizeof(out));
+        return out;
+#else
+        uint32_t bits, sign, mant, half, rem, out;
+        int32_t exp, shift;
+        memcpy(&bits, &in, sizeof(bits));
+        sign = (bits >> 16) & 0x8000;
+        exp = (int32_t)((bits >> 23) & 0xff) - 112;
+        mant = bits & 0x7fffff;
+        // overflow / inf / nan - nan is stored as inf
+        if(exp >= 31) {
+            return sign | 0x7c00;
+        }
+        // subnormal / zero
+        if(exp <= 0) {
+            if(exp < -10) {
+                return sign;
+            }
+            mant |= 0x800000;
+            shift = 14 - exp;
+            out = mant >> shift;
+            rem = mant & ((1 << shift) - 1);
+            half = 1 << (shift - 1);
+        }
+        else {
+            out = ((uint32_t)exp << 10) | (mant >> 13);
+            rem = mant & 0x1fff;
+            half = 0x1000;
+        }
+        // round to nearest even - a carry rounds up into the exponent
+        if(rem > half || (rem == half && (out & 1))) {
+            out ++;
+        }
+        return sign | out;
+#endif
+    }
+
+    // convert a block of stored values - addresses run down from in
+    static inline void loadBlock(const uint16_t *in, float *out, int len) {
+        int i = 0;
+#if defined(__F16C__)
+        __m128 val;
+        for(; i + 4 <= len; i += 4) {
+            val = _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)(in - i - 3)));
+            _mm_storeu_ps(&out[i], _mm_shuffle_ps(val, val, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+#endif
+        for(; i < len; i ++) {
+            out[i] = load(in[-i]);
+        }
+    }
+
+    // convert a block to stored values - addresses run down from out
+    static inline void storeBlock(uint16_t *out, const float *in, int len) {
+        int i = 0;
+#if defined(__F16C__)
+        __m128 val;
+        for(; i + 4 <= len; i += 4) {
+            val = _mm_loadu_ps(&in[i]);
+            val = _mm_shuffle_ps(val, val, _MM_SHUFFLE(0, 1, 2, 3));
+            _mm_storel_epi64((__m128i *)(out - i - 3),
+                _mm_cvtps_ph(val, _MM_FROUND_TO_NEAREST_INT));
+        }
+#endif
+        for(; i < len; i ++) {
+            out[-i] = store(in[i]);
+        }
+    }
+};
+
+// delay line storage - bfloat16 - full float range with 8 bits of mantissa
+// the conversion is plain integer math so the block loops vectorize
+struct DelayStorageBF16 {
+    typedef uint16_t type;
+
+    // convert stored value to float
+    static inline float load(uint16_t in) {
+        uint32_t bits = (uint32_t)in << 16;
+        float out;
+        memcpy(&out, &bits, sizeof(out));
+        return out;
+    }
+
+    // convert float to stored value - round to nearest even
+    static inline uint16_t store(float in) {
+        uint32_t bits;
+        memcpy(&bits, &in, sizeof(bits));
+        bits += 0x7fff + ((bits >> 16) & 1);
+        return (uint16_t)(bits >> 16);
+    }
+
+    // convert a block of stored values - addresses run down from in
+    static inline void loadBlock(const uint16_t *in, float *out, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[i] = load(in[-i]);
+        }
+    }
+
+    // convert a block to stored values - addresses run down from out
+    static inline void storeBlock(uint16_t *out, const float *in, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[-i] = store(in[i]);
+        }
+    }
+};
+
+// delay line storage - 16 bit float - IEEE half if the CPU converts it
+// in hardware, otherwise bfloat16
+#if defined(__F16C__) || defined(__aarch64__)
+typedef DelayStorageHalf DelayStorageFloat16;
+#else
+typedef DelayStorageBF16 DelayStorageFloat16;
+#endif
+
+// delay line with rotating and interpolation - no virtual calls so
+// everything can be inlined into the caller
+// Storage - DelayStorageFloat, DelayStorage16, DelayStorageHalf,
+//   DelayStorageBF16 or DelayStorageFloat16
+// Length - a fixed power of 2 length using built in memory, or
+//   0 for a length set at runtime with setBuffer()
+template <typename Storage, int Length = 0>
+struct DelayLine {
+    typedef typename Storage::type type;
+    static_assert((Length & (Length - 1)) == 0, "Length must be a power of 2");
+    type *delay;  // delay memory
     int dlen;  // delay memory length (must be a power of 2)
     int dp;  // delay memory pointer
-    int preallocated;  // 1 = a preallocated buffer was passed in
+    type mem[Length > 0 ? Length : 1];  // built in memory for a fixed length
 
-    // constructor - pass a pre-allocated buffer and length
-    DelayMem() {
-        dlen = 0;
+    // constructor - a fixed length is cleared and ready to use
+    DelayLine() {
+        dp = 0;
+        if(Length > 0) {
+            delay = mem;
+            dlen = Length;
+            clear();
+        }
+        else {
+            delay = NULL;
+            dlen = 0;
+        }
+    }
+
+    // the delay pointer may point into this object
+    DelayLine(const DelayLine &) = delete;
+    DelayLine &operator=(const DelayLine &) = delete;
+
+    // use a pre-allocated buffer and length - only for runtime lengths
+    // the length is the number of samples and must be a power of 2
+    // the buffer is not cleared so it must be cleared already
+    void setBuffer(type *buf, int len) {
+        delay = buf;
+        dlen = len;
         dp = 0;
-        preallocated = 0;
     }
 
+    // get the address mask - constant for a fixed length
+    inline int mask(void) const {
+        return (Length > 0 ? Length : dlen) - 1;
+    }
+
+    // clear the memory
+    void clear(void) {
+        int i;
+        for(i = 0; i <= mask(); i ++) {
+            delay[i] = Storage::store(0.0f);
+        }
+    }
+
+    // rotate the memory
+    inline void rotate(void) {
+        dp = (dp - 1) & mask();
+    }
+
+    // read a sample by address no interpolation
+    // addr: address to read from
+    inline float read(int addr) {
+        return Storage::load(delay[(dp + addr) & mask()]);
+    }
+
+    // read a sample by address interpolated
+    // addr - the address to read from as a float - real = addr, fract = interp
+    inline float readFract(float addr) {
+        float it1 = addr - (int)addr;
+        float out = Storage::load(delay[(dp + (int)addr) & mask()]) * (1.0 - it1);
+        out += Storage::load(delay[(dp + ((int)addr + 1)) & mask()]) * it1;
+        return out;
+    }
+
+    // read a sample by address interpolated
+    // addr - the whole address to read from
+    // fract - the interpolation to addr + 1 - range: 0.0f to 1.0f
+    inline float readFract(int addr, float fract) {
+        float out = Storage::load(delay[(dp + addr) & mask()]) * (1.0f - fract);
+        out += Storage::load(delay[(dp + addr + 1) & mask()]) * fract;
+        return out;
+    }
+
+    // write into the delay line
+    // addr - the address to write to
+    // in - the input var
+    inline void write(int addr, float in) {
+        delay[(dp + addr) & mask()] = Storage::store(in);
+    }
+
+    // inaddr - the address to write to
+    // outaddr - the address to read from
+    // feeback - AP feedback coeff - + = alternating sign, - = same sign
+    // inout - used for input and output
+    inline void allpass(int inaddr, int outaddr, float feedback, float *inout) {
+        float it1 = Storage::load(delay[(dp + outaddr) & mask()]);
+        *inout += it1 * -feedback;
+        delay[(dp + inaddr) & mask()] = Storage::store(*inout);
+        *inout = (*inout * feedback) + it1;
+    }
+
+    // inaddr - the address to write to
+    // outaddr - the address to read from as a float - real = addr, fract = interp
+    // feedback - AP feedback coeff
+    // acc - used for input and output
+    inline void allpassFract(int inaddr, float outaddr, float feedback, float *inout) {
+        float it2 = outaddr - (int)outaddr;
+        float it1 = Storage::load(delay[(dp + (int)outaddr) & mask()]) * (1.0 - it2);
+        it1 += Storage::load(delay[(dp + ((int)outaddr + 1)) & mask()]) * it2;
+        *inout += (it1 * -feedback);
+        delay[(dp + inaddr) & mask()] = Storage::store(*inout);
+        *inout = (*inout * feedback) + it1;
+    }
+
+    // block calls - sample i of a block is the sample the single sample
+    // calls would see after i more calls to rotate() so blocks are in
+    // time order and addresses run down through memory - call
+    // rotateBlock() with the block length after the block calls
+    // each block is split into at most two contiguous runs at the wrap
+
+    // rotate the memory by a block of samples
+    // len - the number of samples
+    inline void rotateBlock(int len) {
+        dp = (dp - len) & mask();
+    }
+
+    // read a block of samples no interpolation
+    // addr - the address to read the first sample from
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    inline void readBlock(int addr, float *out, int len) {
+        int base, run;
+        while(len > 0) {
+            base = (dp + addr) & mask();
+            run = (len < base + 1) ? len : base + 1;
+            Storage::loadBlock(&delay[base], out, run);
+            addr -= run;
+            out += run;
+            len -= run;
+        }
+    }
+
+    // read a block of samples interpolated
+    // addr - the whole address to read the first sample from
+    // fract - the interpolation to addr + 1 - range: 0.0f to 1.0f
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    inline void readFractBlock(int addr, float fract, float *out, int len) {
+        fractBlock<false>(addr, fract, 1.0f, out, len);
+    }
+
+    // read a block of samples interpolated
+    // addr - the address to read the first sample from as a float
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    inline void readFractBlock(float addr, float *out, int len) {
+        fractBlock<false>((int)addr, addr - (int)addr, 1.0f, out, len);
+    }
+
+    // read a block of samples from several interpolated taps and mix them
+    // addr - the tap addresses as floats
+    // gain - the tap gains
+    // taps - the number of taps
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    inline void readTaps(const float *addr, const float *gain, int taps,
+            float *out, int len) {
+        int i;
+        for(i = 0; i < len; i ++) {
+            out[i] = 0.0f;
+        }
+        for(i = 0; i < taps; i ++) {
+            fractBlock<true>((int)addr[i], addr[i] - (int)addr[i], gain[i], out, len);
+        }
+    }
+
+    // write a block of samples
+    // addr - the address to write the first sample to
+    // in - the input buffer
+    // len - the number of samples - max: dlen
+    inline void writeBlock(int addr, const float *in, int len) {
+        int base, run;
+        while(len > 0) {
+            base = (dp + addr) & mask();
+            run = (len < base + 1) ? len : base + 1;
+            Storage::storeBlock(&delay[base], in, run);
+            addr -= run;
+            in += run;
+            len -= run;
+        }
+    }
+
+    // run an allpass over a block of samples
+    // a delay shorter than the block is run in runs of the delay length
+    // inaddr - the address to write to
+    // outaddr - the address to read from
+    // feeback - AP feedback coeff - + = alternating sign, - = same sign
+    // inout - the block used for input and output
+    // len - the number of samples
+    inline void allpassBlock(int inaddr, int outaddr, float feedback,
+            float *inout, int len) {
+        int i, rbase, wbase, run;
+        const type *r;
+        type *w;
+        float it1, acc;
+        while(len > 0) {
+            rbase = (dp + outaddr) & mask();
+            wbase = (dp + inaddr) & mask();
+            run = (len < rbase + 1) ? len : rbase + 1;
+            run = (run < wbase + 1) ? run : wbase + 1;
+            if(outaddr > inaddr && outaddr - inaddr < run) {
+                run = outaddr - inaddr;
+            }
+            r = &delay[rbase];
+            w = &delay[wbase];
+            for(i = 0; i < run; i ++) {
+                it1 = Storage::load(r[-i]);
+                acc = inout[i] + (it1 * -feedback);
+                w[-i] = Storage::store(acc);
+                inout[i] = (acc * feedback) + it1;
+            }
+            inaddr -= run;
+            outaddr -= run;
+            inout += run;
+            len -= run;
+        }
+    }
+
+    // interpolated block read - Mix = true mixes into out with gain
+    template <bool Mix>
+    inline void fractBlock(int addr, float fract, float gain,
+            float *out, int len) {
+        int i, base, run;
+        const type *p;
+        float fa = (1.0f - fract) * gain;
+        float fb = fract * gain;
+        while(len > 0) {
+            // base is the address + 1 sample so both samples in a run
+            // come from the same side of the wrap
+            base = (dp + addr + 1) & mask();
+            if(base == 0) {
+                if(Mix) out[0] += readFract(addr, fract) * gain;
+                else out[0] = readFract(addr, fract);
+                run = 1;
+            }
+            else {
+                run = (len < base) ? len : base;
+                p = &delay[base];
+                for(i = 0; i < run; i ++) {
+                    if(Mix) {
+                        out[i] += Storage::load(p[-i - 1]) * fa +
+                            Storage::load(p[-i]) * fb;
+                    }
+                    else {
+                        out[i] = Storage::load(p[-i - 1]) * (1.0f - fract) +
+                            Storage::load(p[-i]) * fract;
+                    }
+                }
+            }
+            addr -= run;
+            out += run;
+            len -= run;
+        }
+    }
+};
+
+// delay memory interface - for code that picks the storage at runtime
+// new code should use DelayLine directly
+struct DelayMem {
     // destructor
     virtual ~DelayMem() { }
 
@@ -381,6 +1138,12 @@ struct DelayMem {
     // addr - the address to read from as a float - real = addr, fract = interp
     virtual float readFract(float addr) { return 0.0f; }
 
+    // read a sample by address interpolated - for long delays where a
+    // float address can't hold the fraction
+    // addr - the whole address to read from
+    // fract - the interpolation to addr + 1 - range: 0.0f to 1.0f
+    virtual float readFract(int addr, float fract) { return 0.0f; }
+
     // write into the delay line
     // addr - the address to write to
     // in - the input var
@@ -399,14 +1162,65 @@ struct DelayMem {
     // acc - used for input and output
     virtual void allpassFract(int inaddr, float outaddr,
         float feedback, float *inout) { }
+
+    // block calls - see DelayLine - the defaults loop over the
+    // single sample calls
+
+    // rotate the memory by a block of samples
+    // len - the number of samples
+    virtual void rotateBlock(int len);
+
+    // read a block of samples no interpolation
+    // addr - the address to read the first sample from
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    virtual void readBlock(int addr, float *out, int len);
+
+    // read a block of samples interpolated
+    // addr - the whole address to read the first sample from
+    // fract - the interpolation to addr + 1 - range: 0.0f to 1.0f
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    virtual void readFractBlock(int addr, float fract, float *out, int len);
+
+    // read a block of samples from several interpolated taps and mix them
+    // addr - the tap addresses as floats
+    // gain - the tap gains
+    // taps - the number of taps
+    // out - the output buffer
+    // len - the number of samples - max: dlen
+    virtual void readTaps(const float *addr, const float *gain, int taps,
+        float *out, int len);
+
+    // write a block of samples
+    // addr - the address to write the first sample to
+    // in - the input buffer
+    // len - the number of samples - max: dlen
+    virtual void writeBlock(int addr, const float *in, int len);
+
+    // run an allpass over a block of samples
+    // inaddr - the address to write to
+    // outaddr - the address to read from
+    // feeback - AP feedback coeff - + = alternating sign, - = same sign
+    // inout - the block used for input and output
+    // len - the number of samples
+    virtual void allpassBlock(int inaddr, int outaddr, float feedback,
+        float *inout, int len);
 };
 
 // delay memory with rotating and interpolation
-struct DelayMemFloat : DelayMem {
-    float *delay;  // delay memory
-    int dlen;  // delay memory length (must be a power of 2)
-    int dp;  // delay memory pointer
+// adapts DelayLine to the DelayMem interface
+// a mirrored buffer has a second copy of the memory right after the
+// first so any span of up to dlen samples can be read without wrapping
+struct DelayMemFloat : DelayMem, DelayLine<DelayStorageFloat> {
+    typedef DelayLine<DelayStorageFloat> Line;
+    enum {
+        MIRROR_NONE,  // plain ring
+        MIRROR_MAPPED,  // the same pages are mapped twice
+        MIRROR_COPY  // writes are copied into the second half
+    };
     int preallocated;  // 1 = a preallocated buffer was passed in
+    int mirror;  // mirror type
 
     // constructor - pass a pre-allocated buffer and length
     // the length is the number of samples and must be a power of 2
@@ -416,22 +1230,22 @@ struct DelayMemFloat : DelayMem {
     // power of 2 and the memory is allocated
     DelayMemFloat(int minLen);
 
+    // constructor - the min len is rounded up to the next
+    // power of 2 and a mirrored buffer is allocated
+    // the pages are mapped twice where possible (Linux) and
+    // otherwise writes are copied into the second half
+    DelayMemFloat(int minLen, bool mirrored);
+
     // destructor
     ~DelayMemFloat();
 
     // clear the memory
     void clear(void) override;
 
-    // rotate the memory
-    void rotate(void) override;
-
-    // read a sample by address no interpolation
-    // addr: address to read from
-    float read(int addr) override;
-
-    // read a sample by address interpolated
-    // addr - the address to read from as a float - real = addr, fract = interp
-    float readFract(float addr) override;
+    void rotate(void) override { Line::rotate(); }
+    float read(int addr) override { return Line::read(addr); }
+    float readFract(float addr) override { return Line::readFract(addr); }
+    float readFract(int addr, float fract) override { return Line::readFract(addr, fract); }
 
     // write into the delay line
     // addr - the address to write to
@@ -451,11 +1265,50 @@ struct DelayMemFloat : DelayMem {
     // acc - used for input and output
     void allpassFract(int inaddr, float outaddr,
         float feedback, float *inout) override;
+
+    // get a pointer to a span of samples - mirrored buffers only
+    // addr - the address of the first sample
+    // returns a pointer that is valid for up to dlen samples
+    inline const float *span(int addr) {
+        return &delay[(dp + addr) & (dlen - 1)];
+    }
+
+    void rotateBlock(int len) override { Line::rotateBlock(len); }
+
+    // read a block of samples no interpolation
+    // a mirrored buffer reads the block in one run
+    void readBlock(int addr, float *out, int len) override;
+
+    // read a block of samples interpolated
+    // a mirrored buffer reads the block in one run
+    void readFractBlock(int addr, float fract, float *out, int len) override;
+
+    // read a block of samples from several interpolated taps and mix them
+    void readTaps(const float *addr, const float *gain, int taps,
+        float *out, int len) override;
+
+    // write a block of samples
+    void writeBlock(int addr, const float *in, int len) override;
+
+    // run an allpass over a block of samples
+    void allpassBlock(int inaddr, int outaddr, float feedback,
+        float *inout, int len) override;
+
+    // copy a block of the memory into the second half - copy mirror only
+    // addr - the address of the first sample
+    // len - the number of samples
+    void mirrorBlock(int addr, int len);
 };
 
 // delay memory with rotating and interpolation - 16 bit storage
-struct DelayMem16 : DelayMem {
-    int16_t *delay;  // delay memory
+// adapts DelayLine to the DelayMem interface
+// all values are in float - range: -1.0f to +1.0f
+struct DelayMem16 : DelayMem, DelayLine<DelayStorage16> {
+    typedef DelayLine<DelayStorage16> Line;
+    int preallocated;  // 1 = a preallocated buffer was passed in
+
+    // constructor - no memory until setBuffer() is called
+    DelayMem16();
 
     // constructor - pass a pre-allocated buffer and length
     // the length is the number of samples and must be a power of 2
@@ -468,40 +1321,91 @@ struct DelayMem16 : DelayMem {
     // destructor
     ~DelayMem16();
 
-    // clear the memory
-    void clear(void) override;
-
-    // rotate the memory
-    void rotate(void) override;
-
-    // read a sample by address no interpolation
-    // addr: address to read from
-    // returns the value in float - range: -1.0f to +1.0f
-    float read(int addr) override;
+    // use a different pre-allocated buffer and length
+    // the length is the number of samples and must be a power of 2
+    // the buffer is not cleared so it must be cleared already
+    void setBuffer(int16_t *buf, int len);
+
+    void clear(void) override { Line::clear(); }
+    void rotate(void) override { Line::rotate(); }
+    float read(int addr) override { return Line::read(addr); }
+    float readFract(float addr) override { return Line::readFract(addr); }
+    float readFract(int addr, float fract) override { return Line::readFract(addr, fract); }
+    void write(int addr, float in) override { Line::write(addr, in); }
+    void allpass(int inaddr, int outaddr, float feedback, float *inout) override {
+        Line::allpass(inaddr, outaddr, feedback, inout);
+    }
+    void allpassFract(int inaddr, float outaddr, float feedback, float *inout) override {
+        Line::allpassFract(inaddr, outaddr, feedback, inout);
+    }
+    void rotateBlock(int len) override { Line::rotateBlock(len); }
+    void readBlock(int addr, float *out, int len) override {
+        Line::readBlock(addr, out, len);
+    }
+    void readFractBlock(int addr, float fract, float *out, int len) override {
+        Line::readFractBlock(addr, fract, out, len);
+    }
+    void readTaps(const float *addr, const float *gain, int taps,
+            float *out, int len) override {
+        Line::readTaps(addr, gain, taps, out, len);
+    }
+    void writeBlock(int addr, const float *in, int len) override {
+        Line::writeBlock(addr, in, len);
+    }
+    void allpassBlock(int inaddr, int outaddr, float feedback,
+            float *inout, int len) override {
+        Line::allpassBlock(inaddr, outaddr, feedback, inout, len);
+    }
+};
 
-    // read a sample by address interpolated
-    // addr - the address to read from as a float - real = addr, fract = interp
-    // returns the value in float - range: -1.0f to +1.0f
-    float readFract(float addr) override;
+// delay memory with rotating and interpolation - 16 bit float storage
+// adapts DelayLine to the DelayMem interface
+// half the memory of DelayMemFloat without the clipping of DelayMem16
+struct DelayMemFloat16 : DelayMem, DelayLine<DelayStorageFloat16> {
+    typedef DelayLine<DelayStorageFloat16> Line;
+    int preallocated;  // 1 = a preallocated buffer was passed in
 
-    // write into the delay line
-    // addr - the address to write to
-    // in - the input var as a float - range: -1.0f to +1.0f
-    void write(int addr, float in) override;
+    // constructor - pass a pre-allocated buffer and length
+    // the length is the number of samples and must be a power of 2
+    DelayMemFloat16(uint16_t *buf, int len);
 
-    // inaddr - the address to write to
-    // outaddr - the address to read from
-    // feeback - AP feedback coeff - + = alternating sign, - = same sign
-    // inout - used for input and output
-    void allpass(int inaddr, int outaddr,
-        float feedback, float *inout) override;
+    // constructor - the min len is rounded up to the next
+    // power of 2 and the memory is allocated
+    DelayMemFloat16(int minLen);
 
-    // inaddr - the address to write to
-    // outaddr - the address to read from as a float - real = addr, fract = interp
-    // feedback - AP feedback coeff
-    // acc - used for input and output
-    void allpassFract(int inaddr, float outaddr,
-        float feedback, float *inout) override;
+    // destructor
+    ~DelayMemFloat16();
+
+    void clear(void) override { Line::clear(); }
+    void rotate(void) override { Line::rotate(); }
+    float read(int addr) override { return Line::read(addr); }
+    float readFract(float addr) override { return Line::readFract(addr); }
+    float readFract(int addr, float fract) override { return Line::readFract(addr, fract); }
+    void write(int addr, float in) override { Line::write(addr, in); }
+    void allpass(int inaddr, int outaddr, float feedback, float *inout) override {
+        Line::allpass(inaddr, outaddr, feedback, inout);
+    }
+    void allpassFract(int inaddr, float outaddr, float feedback, float *inout) override {
+        Line::allpassFract(inaddr, outaddr, feedback, inout);
+    }
+    void rotateBlock(int len) override { Line::rotateBlock(len); }
+    void readBlock(int addr, float *out, int len) override {
+        Line::readBlock(addr, out, len);
+    }
+    void readFractBlock(int addr, float fract, float *out, int len) override {
+        Line::readFractBlock(addr, fract, out, len);
+    }
+    void readTaps(const float *addr, const float *gain, int taps,
+            float *out, int len) override {
+        Line::readTaps(addr, gain, taps, out, len);
+    }
+    void writeBlock(int addr, const float *in, int len) override {
+        Line::writeBlock(addr, in, len);
+    }
+    void allpassBlock(int inaddr, int outaddr, float feedback,
+            float *inout, int len) override {
+        Line::allpassBlock(inaddr, outaddr, feedback, inout, len);
+    }
 };
 
 // audio bufferer - can be used for input or output
@@ -541,12 +1445,43 @@ struct AudioBufferer {
     float *getBuf(void);
 };
 
+// allocate memory aligned for vector loads - free with alignedFree()
+// size - the size in bytes
+// align - the alignment in bytes - must be a power of 2
+void *alignedMalloc(size_t size, int align);
+
+// free memory from alignedMalloc()
+void alignedFree(void *ptr);
+
+// dot product of two arrays in 4 lane vectors
+// a, b - the arrays - no alignment is needed but aligned is faster
+// len - the number of samples - must be a multiple of 8
+inline float dotProduct8(const float *a, const float *b, int len) {
+    Float4Vec acc0 = Float4Vec{}, acc1 = Float4Vec{};
+    Float4Vec va, vb;
+    int i;
+    for(i = 0; i < len; i += 8) {
+        memcpy(&va, &a[i], sizeof(va));
+        memcpy(&vb, &b[i], sizeof(vb));
+        acc0 += va * vb;
+        memcpy(&va, &a[i + 4], sizeof(va));
+        memcpy(&vb, &b[i + 4], sizeof(vb));
+        acc1 += va * vb;
+    }
+    acc0 += acc1;
+    return (acc0[0] + acc0[1]) + (acc0[2] + acc0[3]);
+}
+
 // mono FIR filter
+// the coeffs are reversed and the history is stored twice so every
+// output is one contiguous dot product with no wrap
 struct FIRFilter {
-    float *hist;
-    float *coeffs;
+    static constexpr int ALIGN = 32;  // memory alignment in bytes
+    float *hist;  // history - histlen samples stored twice
+    float *coeffs;  // reversed coeffs - zero padded at the start to histlen
     int histpos;
     int numtaps;
+    int histlen;  // numtaps rounded up to a multiple of 8
 
     // constructor
     // taps - the number of FIR taps
@@ -558,6 +1493,277 @@ struct FIRFilter {
 
     // process a sample and returns next output sample
     float process(float in);
+
+    // process a block
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void process(const float *in, float *out, int len);
+};
+
+// real FFT - self contained radix 2
+// the spectrum is stored as separate real and imag arrays of size / 2 + 1
+// bins so that spectrum math runs in plain vectorizable loops
+struct RealFFT {
+    int size;  // the number of real samples - a power of 2
+    int half;  // the size of the complex FFT used inside
+    int *bitrev;  // bit reverse table for the complex FFT
+    float *twr;  // complex FFT twiddles - real
+    float *twi;  // complex FFT twiddles - imag
+    float *splr;  // real split twiddles - real
+    float *spli;  // real split twiddles - imag
+    float *workr;  // work buffer - real
+    float *worki;  // work buffer - imag
+
+    // constructor
+    // size - the number of real samples - a power of 2 from 4
+    RealFFT(int size);
+
+    // destructor
+    ~RealFFT();
+
+    // forward transform
+    // in - size real samples
+    // re - size / 2 + 1 bins - real
+    // im - size / 2 + 1 bins - imag
+    void forward(const float *in, float *re, float *im);
+
+    // inverse transform - scaled so that inverse(forward(x)) = x
+    // re - size / 2 + 1 bins - real
+    // im - size / 2 + 1 bins - imag
+    // out - size real samples
+    void inverse(const float *re, const float *im, float *out);
+
+    // run the complex FFT on the work buffer in place
+    void complexFFT(void);
+};
+
+// uniformly partitioned FFT convolution - overlap-save
+// the first block of the impulse response runs in a direct form FIR
+// so there is no latency, and the rest is split into block sized
+// partitions that are convolved in the frequency domain against a
+// frequency domain delay line of past input blocks
+// the cost per sample is the head FIR plus about log2(blockSize) for the
+// FFTs and irlen / blockSize complex multiplies - the FFT work all
+// happens on the last sample of each block
+struct FFTConvolver {
+    int blockSize;  // partition size
+    int bins;  // FFT bins per partition
+    int parts;  // number of tail partitions
+    int pos;  // position in the current block
+    int fdlpos;  // newest slot in the frequency domain delay line
+    RealFFT *fft;
+    FIRFilter *head;  // the first block of the impulse response
+    float *hre;  // tail partition spectra - real
+    float *him;  // tail partition spectra - imag
+    float *fdlre;  // input block spectra - real
+    float *fdlim;  // input block spectra - imag
+    float *accre;  // spectrum accumulator - real
+    float *accim;  // spectrum accumulator - imag
+    float *window;  // the previous and current input block
+    float *tail;  // tail output for the current block
+    float *work;  // inverse FFT output
+
+    // constructor
+    // blockSize - the partition size - a power of 2 from 16 to 8192
+    // ir - the impulse response (copied internally)
+    // irlen - the impulse response length
+    FFTConvolver(int blockSize, const float *ir, int irlen);
+
+    // destructor
+    ~FFTConvolver();
+
+    // clear the history
+    void reset(void);
+
+    // process a sample and returns next output sample
+    float process(float in);
+
+    // process a block
+    // in - the input samples
+    // out - the output samples - can be the same as in
+    // len - the number of samples
+    void process(const float *in, float *out, int len);
+
+    // run the tail partitions at the end of a block
+    void processTail(void);
+};
+
+// polyphase FIR decimator - integer factor
+// only every factor-th output is computed
+struct PolyphaseDecimator {
+    static constexpr int MAX_FACTOR = 8;
+    static constexpr int TAPS_PER_PHASE = 16;
+    static constexpr int MAX_TAPS = MAX_FACTOR * TAPS_PER_PHASE;
+    float coeffs[MAX_TAPS];  // reversed so the dot product runs forwards
+    float hist[MAX_TAPS * 2];  // stored twice so the history is contiguous
+    int histpos;
+    int numtaps;
+    int factor;
+    int phase;
+
+    // constructor
+    PolyphaseDecimator();
+
+    // set the decimation factor - 1 to MAX_FACTOR
+    // this designs the filter and clears the history
+    void setFactor(int factor);
+
+    // process an input sample
+    // returns 1 and sets out when an output sample is ready
+    int process(float in, float *out);
+};
+
+// polyphase FIR interpolator - integer factor
+struct PolyphaseInterpolator {
+    static constexpr int MAX_FACTOR = PolyphaseDecimator::MAX_FACTOR;
+    static constexpr int TAPS_PER_PHASE = PolyphaseDecimator::TAPS_PER_PHASE;
+    float coeffs[MAX_FACTOR * TAPS_PER_PHASE];  // per phase and reversed
+    float hist[TAPS_PER_PHASE * 2];  // stored twice so the history is contiguous
+    int histpos;
+    int factor;
+    int phase;
+
+    // constructor
+    PolyphaseInterpolator();
+
+    // set the interpolation factor - 1 to MAX_FACTOR
+    // this designs the filter and clears the history
+    void setFactor(int factor);
+
+    // push an input sample at the low rate
+    void push(float in);
+
+    // get the next output sample at the high rate
+    // call this factor times after each push()
+    float process(void);
+};
+
+// design a windowed-sinc lowpass FIR
+// coeffs - the array to fill in with numtaps coeffs
+// cutoff - cutoff frequency as a fraction of the samplerate (0.0 to 0.5)
+// the DC gain is normalized to 1.0
+void designLowpassFIR(float *coeffs, int numtaps, float cutoff);
+
+// half-band FIR quality presets - stopband from a Kaiser windowed sinc
+// with the passband up to 0.4 of the low rate
+enum {
+    HALFBAND_LOW,  // 31 taps - 52dB
+    HALFBAND_MEDIUM,  // 47 taps - 70dB
+    HALFBAND_HIGH,  // 63 taps - 91dB
+    HALFBAND_NUM_QUALITY
+};
+
+// design a half-band lowpass FIR
+// only the odd taps out from the centre are stored because the centre
+// tap is always 0.5 and the other even taps are always 0
+// coeffs - the array to fill in with up to HalfbandInterpolator::MAX_TAPS
+//   coeffs - coeffs[j] is the tap at +/-(2j + 1) from the centre
+// quality - HALFBAND_*
+// stage - 0 = the first 2x stage, 1 = a later 2x stage which only has
+//   to keep the original band so it can use a much shorter filter
+// returns the number of coeffs
+int designHalfbandFIR(float *coeffs, int quality, int stage);
+
+// polyphase half-band 2x interpolator
+// one output phase is a delayed copy of the input and the other phase
+// is a symmetric FIR so each input costs taps multiplies
+struct HalfbandInterpolator {
+    static constexpr int MAX_TAPS = 16;
+    float coeffs[MAX_TAPS];  // odd taps - doubled for the zero stuffing
+    float hist[MAX_TAPS * 4];  // stored twice so the history is contiguous
+    int histpos;
+    int taps;
+
+    // constructor
+    HalfbandInterpolator();
+
+    // set the quality - this designs the filter and clears the history
+    // quality - HALFBAND_*
+    // stage - 0 = first 2x stage, 1 = later 2x stage
+    void setQuality(int quality, int stage);
+
+    // get the latency in output samples
+    int getLatency(void);
+
+    // process an input sample
+    // out - 2 output samples
+    void process(float in, float *out);
+
+    // process a block
+    // in - the input samples
+    // out - len * 2 output samples
+    // len - the number of input samples
+    void processBlock(const float *in, float *out, int len);
+};
+
+// polyphase half-band 2x decimator
+// one input phase only goes through the centre tap and the other phase
+// goes through a symmetric FIR so each output costs taps multiplies
+struct HalfbandDecimator {
+    static constexpr int MAX_TAPS = HalfbandInterpolator::MAX_TAPS;
+    float coeffs[MAX_TAPS];  // odd taps
+    float even[MAX_TAPS * 4];  // even input history - stored twice
+    float odd[MAX_TAPS * 4];  // odd input history - stored twice
+    int histpos;
+    int taps;
+
+    // constructor
+    HalfbandDecimator();
+
+    // set the quality - this designs the filter and clears the history
+    // quality - HALFBAND_*
+    // stage - 0 = first 2x stage, 1 = later 2x stage
+    void setQuality(int quality, int stage);
+
+    // get the latency in input samples
+    int getLatency(void);
+
+    // process a pair of input samples
+    // in - 2 input samples
+    // returns the output sample
+    float process(const float *in);
+
+    // process a block
+    // in - len * 2 input samples
+    // out - the output samples
+    // len - the number of output samples
+    void processBlock(const float *in, float *out, int len);
+};
+
+// 1x / 2x / 4x oversampler for wrapping a nonlinear stage
+// 4x runs two half-band stages with a shorter filter for the second
+struct Oversampler {
+    static constexpr int MAX_FACTOR = 4;
+    static constexpr int BLOCK = 64;  // internal block size at the low rate
+    HalfbandInterpolator up[2];
+    HalfbandDecimator down[2];
+    float temp[BLOCK * 2];  // 2x rate samples between the stages
+    int factor;
+
+    // constructor
+    Oversampler();
+
+    // set the factor and quality - this clears the history
+    // factor - 1, 2 or 4
+    // quality - HALFBAND_*
+    void setFactor(int factor, int quality);
+
+    // get the latency of upsample() and downsample() together
+    // returns the latency in low rate samples
+    float getLatency(void);
+
+    // upsample a block
+    // in - the low rate samples
+    // out - len * factor high rate samples
+    // len - the number of low rate samples
+    void upsample(const float *in, float *out, int len);
+
+    // downsample a block
+    // in - len * factor high rate samples
+    // out - the low rate samples
+    // len - the number of low rate samples
+    void downsample(const float *in, float *out, int len);
 };
 
 // allpass section
@@ -575,8 +1781,42 @@ struct AllpassSection {
     float process(float in);
 };
 
+// 4 allpass sections in the lanes of a vector - see AllpassSection
+struct AllpassSection4 {
+    Float4Vec out_t2;
+    Float4Vec out_t1;
+    Float4Vec in_t2;
+    Float4Vec in_t1;
+    Float4Vec a2;
+
+    AllpassSection4() {
+        out_t2 = Float4Vec{};
+        out_t1 = Float4Vec{};
+        in_t2 = Float4Vec{};
+        in_t1 = Float4Vec{};
+        a2 = Float4Vec{};
+    }
+
+    // set the coeff of one lane
+    void setCoeff(int lane, float a) {
+        a2[lane] = a * a;
+    }
+
+    inline Float4Vec process(Float4Vec in) {
+        Float4Vec out = a2 * (in + out_t2) - in_t2;
+        out_t2 = out_t1;
+        out_t1 = out;
+        in_t2 = in_t1;
+        in_t1 = in;
+        return out;
+    }
+};
+
 // mono allpass phase shifter with +90 degree phase shift
 struct AllpassPhaseShifter {
+    static constexpr int SECTIONS = 4;
+    static const float PR_COEFF[SECTIONS];  // phase reference path coeffs
+    static const float SH_COEFF[SECTIONS];  // phase shift path coeffs
     struct AllpassSection pr0, pr1, pr2, pr3;
     struct AllpassSection sh0, sh1, sh2, sh3;
     float pr_del;
@@ -590,6 +1830,66 @@ struct AllpassPhaseShifter {
     void process(float in, float *del, float *shift);
 };
 
+// mono allpass phase shifter with the two paths in the lanes of a vector
+// lane 0 is the phase reference path and lane 1 is the phase shift path
+// so each section of both paths runs in one vector op
+// the outputs are the same as AllpassPhaseShifter with no latency
+struct AllpassPhaseShifterVec {
+    AllpassSection4 s0, s1, s2, s3;  // lane 0 = reference, lane 1 = shift
+    float pr_del;
+
+    // constructor
+    AllpassPhaseShifterVec();
+
+    // process a sample and returns next output sample
+    // del = delayed, in phase
+    // shift = delayed, +90deg. phase shift (early)
+    void process(float in, float *del, float *shift);
+};
+
+// mono allpass phase shifter with the 4 sections of each path in the
+// lanes of a vector - the samples are pipelined so lane k works on the
+// sample from k samples ago and each path runs in one vector op
+// the outputs are the same as AllpassPhaseShifter delayed by LATENCY
+struct AllpassPhaseShifterPipelined {
+    static constexpr int LATENCY = AllpassPhaseShifter::SECTIONS - 1;
+    AllpassSection4 pr;  // phase reference path sections
+    AllpassSection4 sh;  // phase shift path sections
+    Float4Vec pr_out;  // the last output of each reference section
+    Float4Vec sh_out;  // the last output of each shift section
+    float pr_del;
+
+    // constructor
+    AllpassPhaseShifterPipelined();
+
+    // process a sample and returns next output sample
+    // del = delayed, in phase
+    // shift = delayed, +90deg. phase shift (early)
+    void process(float in, float *del, float *shift);
+};
+
+// 4 channel allpass phase shifter - one channel per lane
+// each channel matches AllpassPhaseShifter
+struct AllpassPhaseShifter4 {
+    AllpassSection4 pr0, pr1, pr2, pr3;
+    AllpassSection4 sh0, sh1, sh2, sh3;
+    Float4Vec pr_del;
+
+    // constructor
+    AllpassPhaseShifter4();
+
+    // process a sample on each channel
+    // del = delayed, in phase
+    // shift = delayed, +90deg. phase shift (early)
+    void process(Float4Vec in, Float4Vec *del, Float4Vec *shift);
+
+    // process a sample on each channel
+    // in - 4 input samples
+    // del - 4 delayed, in phase samples
+    // shift - 4 delayed, +90deg. phase shift (early) samples
+    void process(const float *in, float *del, float *shift);
+};
+
 // fast sine wave generator based on Z-transform
 // https://www.musicdsp.org/en/latest/Synthesis/9-fast-sine-wave-calculation.html
 // not very high-quality frequency or phase coherence